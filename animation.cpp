@@ -0,0 +1,158 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "animation.h"
+#include "threadpool.h"
+
+/**
+ * @fn	AnimationBatch::AnimationBatch(const SceneBuilder& buildScene, const SceneUpdater& updateScene)
+ * @brief	Constructs a batch of one frame, at time 0, in one shard.
+ * @param	buildScene 	Fills an empty scene with the objects, lights and camera.
+ * @param	updateScene	Moves the objects (and the camera, if it wants) to a given
+ * 						time. It must only touch the scene it is passed.
+ */
+
+AnimationBatch::AnimationBatch(const SceneBuilder& buildScene, const SceneUpdater& updateScene)
+	: buildScene(buildScene), updateScene(updateScene) {
+}
+
+/**
+ * @fn	void AnimationBatch::setTimeRange(double startTime, double endTime, int numFrames)
+ * @brief	Sets the frames to render.
+ * @param	startTime	Time of the first frame.
+ * @param	endTime  	Time of the last frame.
+ * @param	numFrames	Number of frames in the whole animation, across all shards.
+ */
+
+void AnimationBatch::setTimeRange(double startTime, double endTime, int numFrames) {
+	this->startTime = startTime;
+	this->endTime = endTime;
+	this->numFrames = std::max(numFrames, 0);
+}
+
+/**
+ * @fn	void AnimationBatch::setShard(int shardIndex, int numShards)
+ * @brief	Restricts this batch to every numShards-th frame, starting at frame
+ * 			shardIndex, so that several processes can share an animation.
+ * @param	shardIndex	Which shard this is, 0 to numShards - 1.
+ * @param	numShards 	How many shards the frames are split into.
+ */
+
+void AnimationBatch::setShard(int shardIndex, int numShards) {
+	this->numShards = std::max(numShards, 1);
+	this->shardIndex = glm::clamp(shardIndex, 0, this->numShards - 1);
+}
+
+/**
+ * @fn	void AnimationBatch::setFramesInFlight(int framesInFlight)
+ * @brief	Sets how many frames are traced at once. Each costs a copy of the
+ * 			scene and a framebuffer. Tracing whole frames in parallel avoids the
+ * 			per-frame serial work (commit, waiting on the slowest tile) that
+ * 			limits how well one frame scales across cores.
+ * @param	framesInFlight	The number of frames, at least 1.
+ */
+
+void AnimationBatch::setFramesInFlight(int framesInFlight) {
+	this->framesInFlight = std::max(framesInFlight, 1);
+}
+
+/**
+ * @fn	void AnimationBatch::setFrameBufferFormat(FRAMEBUFFER_LAYOUT layout, bool accumulate)
+ * @brief	Sets up the framebuffers frames are traced into, as a single frame's
+ * 			would be, so that a batch's frames match single renders.
+ * @param	layout	  	The framebuffer layout.
+ * @param	accumulate	True ==> colors are kept as floats (see FrameBuffer::setAccumulation).
+ */
+
+void AnimationBatch::setFrameBufferFormat(FRAMEBUFFER_LAYOUT layout, bool accumulate) {
+	this->layout = layout;
+	this->accumulate = accumulate;
+}
+
+/**
+ * @fn	double AnimationBatch::getFrameTime(int frame) const
+ * @brief	The time a frame shows.
+ * @param	frame	The frame number.
+ * @return	The time.
+ */
+
+double AnimationBatch::getFrameTime(int frame) const {
+	if (numFrames < 2) {
+		return startTime;
+	}
+	return startTime + (endTime - startTime) * frame / (numFrames - 1);
+}
+
+/**
+ * @fn	int AnimationBatch::getNumShardFrames() const
+ * @brief	The number of frames this shard renders.
+ * @return	The number of frames.
+ */
+
+int AnimationBatch::getNumShardFrames() const {
+	return shardIndex < numFrames ? (numFrames - shardIndex + numShards - 1) / numShards : 0;
+}
+
+/**
+ * @fn	int AnimationBatch::render(int width, int height, int depth, int antiAliasing, ImageSequence& output)
+ * @brief	Renders this shard's frames. Workers take frames in increasing order,
+ * 			so each worker's scene moves forward in time and its refits stay
+ * 			small. Finished frames are queued on the output's exporter; call its
+ * 			flush to wait for them to reach the disk.
+ * @param 		  	width	   	The image width.
+ * @param 		  	height	   	The image height.
+ * @param 		  	depth	   	The recursion depth.
+ * @param 		  	antiAliasing	n ==> n x n rays per pixel.
+ * @param [in,out]	output	   	Where frame f is saved, as output.getFileName(f).
+ * @return	The number of frames rendered.
+ */
+
+int AnimationBatch::render(int width, int height, int depth, int antiAliasing, ImageSequence& output) {
+	const int numJobs = getNumShardFrames();
+	const int numWorkers = std::max(std::min(framesInFlight, numJobs), 1);
+	const int threadsPerFrame = std::max(ThreadPool::defaultNumThreads() / numWorkers, 1);
+
+	// Scenes are built up front, one at a time, so the builder need not be thread safe.
+	vector<std::unique_ptr<IScene>> scenes(numWorkers);
+	for (auto& scene : scenes) {
+		scene.reset(new IScene());
+		buildScene(*scene);
+	}
+
+	std::atomic<int> nextJob(0);
+	auto work = [&](IScene& scene) {
+		RayTracer rayTracer(black);
+		rayTracer.setTiling(DEFAULT_TILE_SIZE, threadsPerFrame);
+		if (setupTracer) {
+			setupTracer(rayTracer);
+		}
+		FrameBuffer frameBuffer(width, height, layout);
+		frameBuffer.setAccumulation(accumulate);
+		for (int job = nextJob++; job < numJobs; job = nextJob++) {
+			int frame = shardIndex + job * numShards;
+			updateScene(scene, frame, getFrameTime(frame));
+			frameBuffer.clearColorAndDepthBuffers();
+			rayTracer.raytraceScene(frameBuffer, depth, scene, antiAliasing);
+			output.saveFrame(frameBuffer, frame);
+		}
+	};
+
+	vector<std::thread> workers;
+	for (int w = 1; w < numWorkers; w++) {
+		workers.emplace_back(work, std::ref(*scenes[w]));
+	}
+	work(*scenes[0]);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	return numJobs;
+}
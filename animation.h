@@ -0,0 +1,62 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <functional>
+#include "defs.h"
+#include "iscene.h"
+#include "raytracer.h"
+#include "frameexport.h"
+
+/**
+ * @class	AnimationBatch
+ * @brief	Renders the frames of an animation offline, into an image sequence.
+ * 			Frame f is shown at time startTime + f * (endTime - startTime) /
+ * 			(numFrames - 1); before it is traced, the update callback moves the
+ * 			scene to that time and the scene's hierarchy is refit (see
+ * 			IScene::commit).
+ *
+ * 			Frames are parallel two ways. Within a process, framesInFlight frames
+ * 			are traced at once, each by a worker with its own copy of the scene
+ * 			(made by the build callback; textures are shared through the image
+ * 			cache) and its own share of the cores. Across processes, or machines,
+ * 			setShard splits the frames round robin: shard i of n renders frames
+ * 			i, i + n, i + 2n, ... and all shards write into the same sequence.
+ */
+
+class AnimationBatch {
+public:
+	typedef std::function<void(IScene& scene)> SceneBuilder;			//!< fills an empty scene, camera included
+	typedef std::function<void(IScene& scene, int frame, double time)> SceneUpdater;	//!< poses a scene at a time
+	typedef std::function<void(RayTracer& rayTracer)> TracerSetup;		//!< configures a worker's ray tracer
+
+	static const int DEFAULT_TILE_SIZE = 16;
+
+	AnimationBatch(const SceneBuilder& buildScene, const SceneUpdater& updateScene);
+	void setTimeRange(double startTime, double endTime, int numFrames);
+	void setShard(int shardIndex, int numShards);
+	void setFramesInFlight(int framesInFlight);
+	void setTracerSetup(const TracerSetup& setupTracer) { this->setupTracer = setupTracer; }
+	void setFrameBufferFormat(FRAMEBUFFER_LAYOUT layout, bool accumulate);
+	double getFrameTime(int frame) const;
+	int getNumShardFrames() const;
+	int render(int width, int height, int depth, int antiAliasing, ImageSequence& output);
+protected:
+	SceneBuilder buildScene;
+	SceneUpdater updateScene;		//!< called by several workers at once, each with its own scene
+	TracerSetup setupTracer;
+	double startTime = 0.0;
+	double endTime = 1.0;
+	int numFrames = 1;
+	int shardIndex = 0;				//!< this process renders frames shardIndex, shardIndex + numShards, ...
+	int numShards = 1;
+	int framesInFlight = 1;			//!< frames this process traces at once
+	FRAMEBUFFER_LAYOUT layout = LINEAR_LAYOUT;	//!< layout of the workers' framebuffers
+	bool accumulate = false;		//!< true ==> the workers' framebuffers keep colors as floats
+};
@@ -0,0 +1,152 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <algorithm>
+#include "bvh.h"
+
+static const double TRAVERSAL_COST = 0.125;	//!< cost of a box test, relative to a shape test
+static const int MAX_DEPTH = 48;				//!< keeps traversal within its fixed-size stack
+
+/**
+ * @fn	static int buildRange(...)
+ * @brief	Recursively builds the subtree over primOrder[start, end).
+ * @param 		  	primBounds	Bounding box of each primitive.
+ * @param 		  	centroids 	Centroid of each primitive's bounding box.
+ * @param [in,out]	primOrder 	Primitive indices; reordered so each leaf is contiguous.
+ * @param 		  	start	  	First primitive of the range.
+ * @param 		  	end		  	One past the last primitive of the range.
+ * @param 		  	depth	  	Depth of this node.
+ * @param [in,out]	nodes	  	The node array being built.
+ * @return	Index of the subtree's root node.
+ */
+
+static int buildRange(const vector<AABB>& primBounds, const vector<dvec3>& centroids,
+						vector<int>& primOrder, int start, int end, int depth,
+						vector<BVHNode>& nodes) {
+	AABB bounds, centroidBounds;
+	for (int i = start; i < end; i++) {
+		bounds.expand(primBounds[primOrder[i]]);
+		centroidBounds.expand(centroids[primOrder[i]]);
+	}
+
+	int nodeIndex = (int)nodes.size();
+	nodes.push_back(BVHNode());
+	nodes[nodeIndex].bounds = bounds;
+	nodes[nodeIndex].start = start;
+	nodes[nodeIndex].count = end - start;
+	nodes[nodeIndex].secondChild = -1;
+
+	const int N = end - start;
+	if (N == 1 || depth >= MAX_DEPTH) {
+		return nodeIndex;
+	}
+
+	// Find the cheapest binned split over all three axes.
+	const int B = BVH::NUM_BINS;
+	int bestAxis = -1;
+	int bestSplit = -1;
+	double bestCost = DBL_MAX;
+	dvec3 extent = centroidBounds.hi - centroidBounds.lo;
+	for (int axis = 0; axis < 3; axis++) {
+		if (extent[axis] <= 0.0) {
+			continue;
+		}
+		AABB binBounds[B];
+		int binCounts[B] = { 0 };
+		double scale = B / extent[axis];
+		for (int i = start; i < end; i++) {
+			int prim = primOrder[i];
+			int b = glm::min((int)((centroids[prim][axis] - centroidBounds.lo[axis]) * scale), B - 1);
+			binCounts[b]++;
+			binBounds[b].expand(primBounds[prim]);
+		}
+
+		// Sweep from the right to get the area/count of every right-hand side.
+		double rightArea[B];
+		int rightCount[B];
+		AABB accum;
+		int count = 0;
+		for (int b = B - 1; b > 0; b--) {
+			accum.expand(binBounds[b]);
+			count += binCounts[b];
+			rightArea[b] = accum.surfaceArea();
+			rightCount[b] = count;
+		}
+
+		accum = AABB();
+		count = 0;
+		for (int b = 0; b < B - 1; b++) {
+			accum.expand(binBounds[b]);
+			count += binCounts[b];
+			if (count == 0 || rightCount[b + 1] == 0) {
+				continue;
+			}
+			double cost = accum.surfaceArea() * count + rightArea[b + 1] * rightCount[b + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	int mid;
+	if (bestAxis < 0) {
+		// Every centroid is in the same spot, so no plane separates them.
+		if (N <= BVH::MAX_LEAF_SIZE) {
+			return nodeIndex;
+		}
+		mid = start + N / 2;
+	} else {
+		double splitCost = TRAVERSAL_COST + bestCost / bounds.surfaceArea();
+		if (N <= BVH::MAX_LEAF_SIZE && splitCost >= N) {
+			return nodeIndex;
+		}
+		double lo = centroidBounds.lo[bestAxis];
+		double scale = B / extent[bestAxis];
+		int* middle = std::partition(&primOrder[0] + start, &primOrder[0] + end,
+			[&](int prim) {
+				int b = glm::min((int)((centroids[prim][bestAxis] - lo) * scale), B - 1);
+				return b <= bestSplit;
+			});
+		mid = (int)(middle - &primOrder[0]);
+	}
+
+	nodes[nodeIndex].count = 0;
+	buildRange(primBounds, centroids, primOrder, start, mid, depth + 1, nodes);
+	int second = buildRange(primBounds, centroids, primOrder, mid, end, depth + 1, nodes);
+	nodes[nodeIndex].secondChild = second;
+	return nodeIndex;
+}
+
+/**
+ * @fn	void BVH::buildHierarchy(const vector<AABB>& primBounds, vector<BVHNode>& nodes, vector<int>& primOrder)
+ * @brief	Builds a hierarchy over a set of boxes using the binned surface area
+ * 			heuristic. Usable for any kind of primitive.
+ * @param 		  	primBounds	Bounding box of each primitive.
+ * @param [out]		nodes	  	The flattened hierarchy. Node 0 is the root.
+ * @param [out]		primOrder 	Primitive indices, in leaf order.
+ */
+
+void BVH::buildHierarchy(const vector<AABB>& primBounds,
+						vector<BVHNode>& nodes, vector<int>& primOrder) {
+	const int N = (int)primBounds.size();
+	nodes.clear();
+	primOrder.resize(N);
+	if (N == 0) {
+		return;
+	}
+	vector<dvec3> centroids(N);
+	for (int i = 0; i < N; i++) {
+		primOrder[i] = i;
+		centroids[i] = primBounds[i].centroid();
+	}
+	nodes.reserve(2 * N);
+	buildRange(primBounds, centroids, primOrder, 0, N, 0, nodes);
+}
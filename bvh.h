@@ -0,0 +1,107 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <vector>
+#include "defs.h"
+#include "ishape.h"
+
+/**
+ * @struct	BVHNodeT
+ * @brief	A node of a flattened bounding volume hierarchy. The first child of an
+ * 			interior node immediately follows it in the node array; the second child
+ * 			is at secondChild. A leaf covers primitives [start, start + count) of the
+ * 			hierarchy's primitive order.
+ */
+
+template <class T>
+struct BVHNodeT {
+	AABBT<T> bounds;	//!< box enclosing everything below this node
+	int start;			//!< leaf: first primitive
+	int count;			//!< leaf: number of primitives. 0 ==> interior node
+	int secondChild;	//!< interior: index of the second child
+	bool isLeaf() const { return count > 0; }
+};
+
+typedef BVHNodeT<double> BVHNode;
+
+/**
+ * @namespace	BVH
+ * @brief	Bounding volume hierarchies over boxes, built with the binned surface
+ * 			area heuristic and flattened into arrays of BVHNodeT. The owners
+ * 			(CompiledScene, ITriangleMesh, LightTree) keep their primitives in
+ * 			leaf order; these functions only build and walk the nodes.
+ */
+
+namespace BVH {
+
+const int MAX_LEAF_SIZE = 4;		//!< leaves never hold more than this
+const int NUM_BINS = 16;			//!< SAH bins per split
+
+void buildHierarchy(const vector<AABB>& primBounds,
+					vector<BVHNode>& nodes, vector<int>& primOrder);
+
+/**
+ * @fn	template <class T, class LeafFunc> void BVH::traverse(...)
+ * @brief	Walks the nodes hit by a ray, nearest child first, and calls
+ * 			visitLeaf(start, count, tMax) for every leaf reached. The visitor may
+ * 			shrink tMax to cull the rest of the traversal, and returns true to stop
+ * 			traversing altogether.
+ * @param 		  	nodes	  	The flattened hierarchy.
+ * @param 		  	origin	  	The ray's origin.
+ * @param 		  	invDir	  	Componentwise reciprocal of the ray's direction.
+ * @param [in,out]	tMax	  	Farthest distance of interest.
+ * @param 		  	visitLeaf 	Called for each leaf.
+ */
+
+template <class T, class LeafFunc>
+void traverse(const vector<BVHNodeT<T>>& nodes, const glm::tvec3<T>& origin, const glm::tvec3<T>& invDir,
+			T& tMax, LeafFunc visitLeaf) {
+	if (nodes.empty()) {
+		return;
+	}
+	const int STACK_SIZE = 64;
+	int stack[STACK_SIZE];
+	int top = 0;
+	T tEnter;
+	if (!nodes[0].bounds.intersect(origin, invDir, tMax, tEnter)) {
+		return;
+	}
+	stack[top++] = 0;
+	while (top > 0) {
+		const BVHNodeT<T>& node = nodes[stack[--top]];
+		if (node.isLeaf()) {
+			if (visitLeaf(node.start, node.count, tMax)) {
+				return;
+			}
+			continue;
+		}
+		int first = (int)(&node - &nodes[0]) + 1;
+		int second = node.secondChild;
+		T tFirst, tSecond;
+		bool hitFirst = nodes[first].bounds.intersect(origin, invDir, tMax, tFirst);
+		bool hitSecond = nodes[second].bounds.intersect(origin, invDir, tMax, tSecond);
+		if (hitFirst && hitSecond) {
+			// Push the farther child first so the nearer one is visited next.
+			if (tFirst < tSecond) {
+				stack[top++] = second;
+				stack[top++] = first;
+			} else {
+				stack[top++] = first;
+				stack[top++] = second;
+			}
+		} else if (hitFirst) {
+			stack[top++] = first;
+		} else if (hitSecond) {
+			stack[top++] = second;
+		}
+	}
+}
+
+}	// namespace BVH
@@ -23,8 +23,27 @@ RaytracingCamera::RaytracingCamera(const dvec3& viewingPos, const dvec3& lookAtP
 	setupFrame(viewingPos, lookAtPt, up);
 }
 
+/**
+ * @fn	vector<Ray> RaytracingCamera::getAARays(int x, int y, int n) const
+ * @brief	Gets all the antialiasing rays for pixel (x, y), in the order
+ * 			getAARay(x, y, i, j, m) visits them with i in the outer loop. m is
+ * 			getAAGridSize(n). Allocates; the ray tracer uses getAARay directly.
+ * @param	x	The x coordinate.
+ * @param	y	The y coordinate.
+ * @param	n	Antialiasing level.
+ * @return	The rays.
+ */
+
 vector<Ray> RaytracingCamera::getAARays(int x, int y, int n) const {
-    return { getRay(x, y) };
+    int m = getAAGridSize(n);
+    vector<Ray> rays;
+    rays.reserve(m * m);
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < m; ++j) {
+            rays.push_back(getAARay(x, y, i, j, m));
+        }
+    }
+    return rays;
 }
 
 /**
@@ -160,10 +179,6 @@ Ray OrthographicCamera::getRay(double x, double y) const {
 	return Ray(cameraFrame.origin + uv.x * cameraFrame.u + uv.y * cameraFrame.v, -cameraFrame.w);
 }
 
-std::vector<Ray> OrthographicCamera::getAARays(int x, int y, int n) const {
-    return { getRay(x, y) };
-}
-
 
 
 /**
@@ -182,19 +197,22 @@ Ray PerspectiveCamera::getRay(double x, double y) const {
 	return Ray(cameraFrame.origin, rayDirection);
 }
 
-vector<Ray> PerspectiveCamera::getAARays(int x, int y, int n) const {
-    vector<Ray> rays;
-    double pixelWidth = 1.0 / n;
-
-    for (int i = 0; i < n; ++i) {
-        for (int j = 0; j < n; ++j) {
-            double u = x + (i + 0.5) * pixelWidth;
-            double v = y + (j + 0.5) * pixelWidth;
-            rays.push_back(getRay(u, v));
-        }
-    }
+/**
+ * @fn	Ray PerspectiveCamera::getAARay(int x, int y, int i, int j, int n) const
+ * @brief	Gets the ray through the center of cell (i, j) of an n x n grid over pixel (x, y).
+ * @param	x	The x coordinate.
+ * @param	y	The y coordinate.
+ * @param	i	Column of the cell.
+ * @param	j	Row of the cell.
+ * @param	n	Cells per side.
+ * @return	The ray.
+ */
 
-    return rays;
+Ray PerspectiveCamera::getAARay(int x, int y, int i, int j, int n) const {
+    double pixelWidth = 1.0 / n;
+    double u = x + (i + 0.5) * pixelWidth;
+    double v = y + (j + 0.5) * pixelWidth;
+    return getRay(u, v);
 }
 
 /**
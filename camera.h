@@ -20,7 +20,9 @@ struct RaytracingCamera {
     RaytracingCamera(const dvec3& pos, const dvec3& lookAtPt, const dvec3& up,
         int width, int height);
     virtual Ray getRay(double x, double y) const = 0;
-    virtual vector<Ray> getAARays(int x, int y, int n) const;
+    virtual int getAAGridSize(int) const { return 1; }
+    virtual Ray getAARay(int x, int y, int, int, int) const { return getRay(x, y); }
+    vector<Ray> getAARays(int x, int y, int n) const;
     Frame getFrame() const { return cameraFrame; }
     int getNX() const { return nx; }
     int getNY() const { return ny; }
@@ -50,7 +52,8 @@ struct PerspectiveCamera : public RaytracingCamera {
     PerspectiveCamera(const dvec3& pos, const dvec3& lookAtPt, const dvec3& up, double FOVRads,
         int width, int height);
     virtual Ray getRay(double x, double y) const;
-    virtual std::vector<Ray> getAARays(int x, int y, int n) const override;
+    virtual int getAAGridSize(int n) const override { return n; }
+    virtual Ray getAARay(int x, int y, int i, int j, int n) const override;
 
     double getDistToPlane() const { return distToPlane; }
 private:
@@ -68,7 +71,6 @@ struct OrthographicCamera : public RaytracingCamera {
     OrthographicCamera(const dvec3& pos, const dvec3& lookAtPt, const dvec3& up,
         int width, int height, double scaleFactor = 1.0);
     virtual Ray getRay(double x, double y) const;
-    virtual std::vector<Ray> getAARays(int x, int y, int n) const override;
 
 private:
     double scale;		//!< Controls the size of the image plane.
@@ -38,6 +38,8 @@ struct Material {
 
 	double alpha = 1.0; //!< transparency material property
 
+	double reflectivity = 0.5;	//!< weight of the mirror reflection the ray tracer adds to opaque hits
+
     // Added to support transparent materials
     // 
     /** @brief	index of refraction for the material  */
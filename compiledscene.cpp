@@ -0,0 +1,848 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <algorithm>
+#include <typeinfo>
+#include "compiledscene.h"
+
+template <class T>
+void QuadricGroup<T>::add(int o, int p, const IQuadricSurface& q, double lo, double hi) {
+	const QuadricParameters& params = q.getParameters();
+	owner.push_back(o);
+	part.push_back(p);
+	cx.push_back((T)q.center.x);
+	cy.push_back((T)q.center.y);
+	cz.push_back((T)q.center.z);
+	A.push_back((T)params.A);
+	B.push_back((T)params.B);
+	C.push_back((T)params.C);
+	D.push_back((T)params.D);
+	E.push_back((T)params.E);
+	F.push_back((T)params.F);
+	G.push_back((T)params.G);
+	H.push_back((T)params.H);
+	I.push_back((T)params.I);
+	J.push_back((T)params.J);
+	yLo.push_back((T)lo);
+	yHi.push_back((T)hi);
+}
+
+template <class T>
+void QuadricGroup<T>::clear() {
+	ShapeGroup::clear();
+	for (vector<T>* v : { &cx, &cy, &cz, &A, &B, &C, &D, &E, &F, &G, &H, &I, &J, &yLo, &yHi }) {
+		v->clear();
+	}
+}
+
+template <class T>
+void PlaneGroup<T>::add(int o, int p, const IPlane& plane) {
+	owner.push_back(o);
+	part.push_back(p);
+	ax.push_back((T)plane.a.x);
+	ay.push_back((T)plane.a.y);
+	az.push_back((T)plane.a.z);
+	nx.push_back((T)plane.n.x);
+	ny.push_back((T)plane.n.y);
+	nz.push_back((T)plane.n.z);
+}
+
+template <class T>
+void PlaneGroup<T>::clear() {
+	ShapeGroup::clear();
+	for (vector<T>* v : { &ax, &ay, &az, &nx, &ny, &nz }) {
+		v->clear();
+	}
+}
+
+template <class T>
+void DiskGroup<T>::add(int o, int p, const IDisk& disk) {
+	owner.push_back(o);
+	part.push_back(p);
+	cx.push_back((T)disk.center.x);
+	cy.push_back((T)disk.center.y);
+	cz.push_back((T)disk.center.z);
+	nx.push_back((T)disk.n.x);
+	ny.push_back((T)disk.n.y);
+	nz.push_back((T)disk.n.z);
+	radius.push_back((T)disk.radius);
+}
+
+template <class T>
+void DiskGroup<T>::clear() {
+	ShapeGroup::clear();
+	for (vector<T>* v : { &cx, &cy, &cz, &nx, &ny, &nz, &radius }) {
+		v->clear();
+	}
+}
+
+template <class T>
+void TriangleGroup<T>::add(int o, int p, const ITriangle& tri) {
+	TriangleDataT<T> data(tri.a, tri.b, tri.c);
+	owner.push_back(o);
+	part.push_back(p);
+	ax.push_back((T)data.a.x);
+	ay.push_back((T)data.a.y);
+	az.push_back((T)data.a.z);
+	nx.push_back((T)data.n.x);
+	ny.push_back((T)data.n.y);
+	nz.push_back((T)data.n.z);
+	e0x.push_back((T)data.v0.x);
+	e0y.push_back((T)data.v0.y);
+	e0z.push_back((T)data.v0.z);
+	e1x.push_back((T)data.v1.x);
+	e1y.push_back((T)data.v1.y);
+	e1z.push_back((T)data.v1.z);
+	d00.push_back((T)data.d00);
+	d01.push_back((T)data.d01);
+	d11.push_back((T)data.d11);
+	denom.push_back((T)data.denom);
+}
+
+template <class T>
+TriangleDataT<T> TriangleGroup<T>::get(int i) const {
+	TriangleDataT<T> data;
+	data.a = glm::tvec3<T>(ax[i], ay[i], az[i]);
+	data.n = glm::tvec3<T>(nx[i], ny[i], nz[i]);
+	data.v0 = glm::tvec3<T>(e0x[i], e0y[i], e0z[i]);
+	data.v1 = glm::tvec3<T>(e1x[i], e1y[i], e1z[i]);
+	data.d00 = d00[i];
+	data.d01 = d01[i];
+	data.d11 = d11[i];
+	data.denom = denom[i];
+	return data;
+}
+
+template <class T>
+void TriangleGroup<T>::clear() {
+	ShapeGroup::clear();
+	for (vector<T>* v : { &ax, &ay, &az, &nx, &ny, &nz, &e0x, &e0y, &e0z,
+							   &e1x, &e1y, &e1z, &d00, &d01, &d11, &denom }) {
+		v->clear();
+	}
+}
+
+template <class T>
+void SphereGroup<T>::add(int o, int p, const IGeometricSphere& sphere) {
+	owner.push_back(o);
+	part.push_back(p);
+	cx.push_back((T)sphere.center.x);
+	cy.push_back((T)sphere.center.y);
+	cz.push_back((T)sphere.center.z);
+	radius.push_back((T)sphere.radius);
+}
+
+template <class T>
+void SphereGroup<T>::clear() {
+	ShapeGroup::clear();
+	for (vector<T>* v : { &cx, &cy, &cz, &radius }) {
+		v->clear();
+	}
+}
+
+void OtherGroup::add(int o, const IShape* shape) {
+	owner.push_back(o);
+	part.push_back(0);
+	shapes.push_back(shape);
+}
+
+void OtherGroup::clear() {
+	ShapeGroup::clear();
+	shapes.clear();
+}
+
+/**
+ * @fn	static void splitIntoPrimitives(const IShape* shape, int owner, vector<Primitive>& prims)
+ * @brief	Splits a shape into primitives. Only exact types are matched, so that a
+ * 			subclass with its own intersection test ends up in OTHER_SHAPE.
+ * @param 		  	shape	The shape.
+ * @param 		  	owner	Index of the object.
+ * @param [in,out]	prims	Where to add the primitives.
+ */
+
+static void splitIntoPrimitives(const IShape* shape, int owner, vector<Primitive>& prims) {
+	const std::type_info& type = typeid(*shape);
+	if (type == typeid(IClosedCylinderY)) {
+		const IClosedCylinderY* cyl = static_cast<const IClosedCylinderY*>(shape);
+		prims.push_back({ CYLINDER_Y_SHAPE, shape, owner, 0 });
+		prims.push_back({ DISK_SHAPE, &cyl->getTop(), owner, 1 });
+		prims.push_back({ DISK_SHAPE, &cyl->getBottom(), owner, 2 });
+	} else if (type == typeid(IClosedConeY)) {
+		const IClosedConeY* cone = static_cast<const IClosedConeY*>(shape);
+		prims.push_back({ CONE_Y_SHAPE, shape, owner, 0 });
+		prims.push_back({ DISK_SHAPE, &cone->base, owner, 1 });
+	} else if (type == typeid(ICylinderY)) {
+		prims.push_back({ CYLINDER_Y_SHAPE, shape, owner, 0 });
+	} else if (type == typeid(IConeY)) {
+		prims.push_back({ CONE_Y_SHAPE, shape, owner, 0 });
+	} else if (type == typeid(IQuadricSurface) || type == typeid(ISphere) || type == typeid(IEllipsoid) ||
+			   type == typeid(ICylinder) || type == typeid(ICone)) {
+		const SHAPE_KIND kinds[] = { QUADRIC_SHAPE, ALIGNED_QUADRIC_SHAPE, SPHERICAL_QUADRIC_SHAPE };
+		int kind = kinds[static_cast<const IQuadricSurface*>(shape)->getForm()];
+		prims.push_back({ kind, shape, owner, 0 });
+	} else if (type == typeid(IGeometricSphere)) {
+		prims.push_back({ GEOMETRIC_SPHERE_SHAPE, shape, owner, 0 });
+	} else if (type == typeid(IPlane)) {
+		prims.push_back({ PLANE_SHAPE, shape, owner, 0 });
+	} else if (type == typeid(IDisk)) {
+		prims.push_back({ DISK_SHAPE, shape, owner, 0 });
+	} else if (type == typeid(ITriangle)) {
+		prims.push_back({ TRIANGLE_SHAPE, shape, owner, 0 });
+	} else {
+		prims.push_back({ OTHER_SHAPE, shape, owner, 0 });
+	}
+}
+
+/**
+ * @fn	static bool primitiveBounds(const Primitive& prim, AABB& box)
+ * @brief	Bounding box of a primitive. The side of a closed cylinder or cone is
+ * 			bounded like the open one, without its caps.
+ * @param 		  	prim	The primitive.
+ * @param [out]		box 	The box.
+ * @return	True iff the primitive is bounded.
+ */
+
+static bool primitiveBounds(const Primitive& prim, AABB& box) {
+	if (prim.kind == CYLINDER_Y_SHAPE) {
+		return static_cast<const ICylinderY*>(prim.shape)->ICylinderY::getBounds(box);
+	} else if (prim.kind == CONE_Y_SHAPE) {
+		return static_cast<const IConeY*>(prim.shape)->IConeY::getBounds(box);
+	}
+	return prim.shape->getBounds(box);
+}
+
+/**
+ * @fn	template <class T> void CompiledSceneT<T>::appendRuns(vector<Primitive>& prims)
+ * @brief	Sorts primitives by kind, stores them in their groups and adds one run
+ * 			per kind present.
+ * @param [in,out]	prims	The primitives; sorted by kind on return.
+ */
+
+template <class T>
+void CompiledSceneT<T>::appendRuns(vector<Primitive>& prims) {
+	std::stable_sort(prims.begin(), prims.end(),
+		[](const Primitive& a, const Primitive& b) { return a.kind < b.kind; });
+	const ShapeGroup* groups[NUM_SHAPE_KINDS] = { &quadrics, &alignedQuadrics, &sphericalQuadrics,
+												  &cylinders, &cones, &spheres, &planes, &disks,
+												  &triangles, &others };
+	for (size_t i = 0; i < prims.size(); i++) {
+		const Primitive& prim = prims[i];
+		if (i == 0 || prim.kind != prims[i - 1].kind) {
+			int begin = groups[prim.kind]->size();
+			runs.push_back({ prim.kind, begin, begin });
+		}
+		storePrimitive(prim);
+		runs.back().end = groups[prim.kind]->size();
+	}
+}
+
+/**
+ * @fn	template <class T> void CompiledSceneT<T>::storePrimitive(const Primitive& prim)
+ * @brief	Adds a primitive to the end of its group, and remembers it for refit.
+ * @param	prim	The primitive.
+ */
+
+template <class T>
+void CompiledSceneT<T>::storePrimitive(const Primitive& prim) {
+	primitives.push_back(prim);
+	switch (prim.kind) {
+	case QUADRIC_SHAPE:
+		quadrics.add(prim.owner, prim.part, *static_cast<const IQuadricSurface*>(prim.shape));
+		break;
+	case ALIGNED_QUADRIC_SHAPE:
+		alignedQuadrics.add(prim.owner, prim.part, *static_cast<const IQuadricSurface*>(prim.shape));
+		break;
+	case SPHERICAL_QUADRIC_SHAPE:
+		sphericalQuadrics.add(prim.owner, prim.part, *static_cast<const IQuadricSurface*>(prim.shape));
+		break;
+	case CYLINDER_Y_SHAPE: {
+		const ICylinderY* cyl = static_cast<const ICylinderY*>(prim.shape);
+		cylinders.add(prim.owner, prim.part, *cyl,
+			cyl->center.y - cyl->length / 2, cyl->center.y + cyl->length / 2);
+		break;
+	}
+	case CONE_Y_SHAPE: {
+		const IConeY* cone = static_cast<const IConeY*>(prim.shape);
+		double yTip = cone->center.y;
+		double yBase = cone->center.y + cone->height;
+		cones.add(prim.owner, prim.part, *cone, yTip - EPSILON, yBase + EPSILON);
+		break;
+	}
+	case GEOMETRIC_SPHERE_SHAPE:
+		spheres.add(prim.owner, prim.part, *static_cast<const IGeometricSphere*>(prim.shape));
+		break;
+	case PLANE_SHAPE:
+		planes.add(prim.owner, prim.part, *static_cast<const IPlane*>(prim.shape));
+		break;
+	case DISK_SHAPE:
+		disks.add(prim.owner, prim.part, *static_cast<const IDisk*>(prim.shape));
+		break;
+	case TRIANGLE_SHAPE:
+		triangles.add(prim.owner, prim.part, *static_cast<const ITriangle*>(prim.shape));
+		break;
+	default:
+		others.add(prim.owner, prim.shape);
+		break;
+	}
+}
+
+/**
+ * @fn	template <class T> void CompiledSceneT<T>::clearGroups()
+ * @brief	Empties every group, along with the list of stored primitives.
+ */
+
+template <class T>
+void CompiledSceneT<T>::clearGroups() {
+	primitives.clear();
+	quadrics.clear();
+	alignedQuadrics.clear();
+	sphericalQuadrics.clear();
+	cylinders.clear();
+	cones.clear();
+	spheres.clear();
+	planes.clear();
+	disks.clear();
+	triangles.clear();
+	others.clear();
+}
+
+/**
+ * @fn	template <class T> static AABBT<T> roundOutward(const AABB& box)
+ * @brief	Converts a box to precision T, rounding its corners outward so the
+ * 			result still encloses the original box.
+ * @param	box	The box.
+ * @return	The enclosing box.
+ */
+
+template <class T>
+static AABBT<T> roundOutward(const AABB& box) {
+	AABBT<T> result;
+	for (int i = 0; i < 3; i++) {
+		T lo = (T)box.lo[i];
+		T hi = (T)box.hi[i];
+		result.lo[i] = lo > box.lo[i] ? std::nextafter(lo, -std::numeric_limits<T>::max()) : lo;
+		result.hi[i] = hi < box.hi[i] ? std::nextafter(hi, std::numeric_limits<T>::max()) : hi;
+	}
+	return result;
+}
+
+/**
+ * @fn	template <class T> void CompiledSceneT<T>::build(const vector<VisibleIShapePtr>& objects)
+ * @brief	(Re)compiles a set of objects. The hierarchy is always built in double
+ * 			precision and then converted.
+ * @param	objects	The objects.
+ */
+
+template <class T>
+void CompiledSceneT<T>::build(const vector<VisibleIShapePtr>& objects) {
+	this->objects = objects;
+	blocksLight.resize(objects.size());
+	shapes.resize(objects.size());
+	runs.clear();
+	clearGroups();
+
+	vector<Primitive> bounded, unbounded;
+	vector<AABB> boxes;
+	for (size_t i = 0; i < objects.size(); i++) {
+		blocksLight[i] = !objects[i]->material.isDielectric;
+		shapes[i] = objects[i]->shape;
+		vector<Primitive> prims;
+		splitIntoPrimitives(objects[i]->shape, (int)i, prims);
+		for (auto& prim : prims) {
+			AABB box;
+			if (primitiveBounds(prim, box)) {
+				bounded.push_back(prim);
+				boxes.push_back(box);
+			} else {
+				unbounded.push_back(prim);
+			}
+		}
+	}
+
+	appendRuns(unbounded);
+	numUnboundedRuns = (int)runs.size();
+
+	// Replace each leaf's primitive range with the range of its runs.
+	vector<int> order;
+	vector<BVHNode> hierarchy;
+	BVH::buildHierarchy(boxes, hierarchy, order);
+	nodes.resize(hierarchy.size());
+	for (size_t n = 0; n < hierarchy.size(); n++) {
+		const BVHNode& node = hierarchy[n];
+		nodes[n].bounds = roundOutward<T>(node.bounds);
+		nodes[n].start = node.start;
+		nodes[n].count = node.count;
+		nodes[n].secondChild = node.secondChild;
+		if (!node.isLeaf()) {
+			continue;
+		}
+		vector<Primitive> leafPrims;
+		for (int i = node.start; i < node.start + node.count; i++) {
+			leafPrims.push_back(bounded[order[i]]);
+		}
+		nodes[n].start = (int)runs.size();
+		appendRuns(leafPrims);
+		nodes[n].count = (int)runs.size() - nodes[n].start;
+	}
+	builtCost = interiorCost();
+}
+
+static const double MAX_REFIT_GROWTH = 2.0;	//!< see refit
+
+/**
+ * @fn	template <class T> bool CompiledSceneT<T>::refit(const vector<VisibleIShapePtr>& objects)
+ * @brief	Updates the compiled scene after objects moved, turned or changed size,
+ * 			without rebuilding the hierarchy. Each primitive is re-read from its
+ * 			shape into the slot it already has, leaf boxes are recomputed from
+ * 			the primitives and interior boxes from their children (which follow
+ * 			their parent in the node array, so one backward pass does it). Refit
+ * 			gives up, leaving the scene to be built, if the objects are not the
+ * 			ones last built, a primitive lost its bounds, or the boxes have grown
+ * 			so much (more than MAX_REFIT_GROWTH times the surface area they had
+ * 			when built) that the old hierarchy no longer pays.
+ * @param	objects	The objects; the same pointers, in the same order, as last built.
+ * @return	True iff the scene was refit. If false, it must be built.
+ */
+
+template <class T>
+bool CompiledSceneT<T>::refit(const vector<VisibleIShapePtr>& objects) {
+	if (objects != this->objects) {
+		return false;
+	}
+	for (size_t i = 0; i < objects.size(); i++) {
+		if (objects[i]->shape != shapes[i]) {
+			return false;
+		}
+		blocksLight[i] = !objects[i]->material.isDielectric;
+	}
+
+	// The primitives are stored again in the same order, so every run still covers the same ones.
+	vector<Primitive> stored;
+	stored.swap(primitives);
+	clearGroups();
+	for (const Primitive& prim : stored) {
+		storePrimitive(prim);
+	}
+
+	size_t next = 0;
+	for (int r = 0; r < numUnboundedRuns; r++) {
+		next += runs[r].end - runs[r].begin;
+	}
+	for (size_t n = 0; n < nodes.size(); n++) {
+		if (!nodes[n].isLeaf()) {
+			continue;
+		}
+		AABB bounds;
+		for (int r = nodes[n].start; r < nodes[n].start + nodes[n].count; r++) {
+			for (int i = runs[r].begin; i < runs[r].end; i++) {
+				AABB box;
+				if (!primitiveBounds(primitives[next++], box)) {
+					return false;
+				}
+				bounds.expand(box);
+			}
+		}
+		nodes[n].bounds = roundOutward<T>(bounds);
+	}
+	for (size_t n = nodes.size(); n-- > 0;) {
+		if (!nodes[n].isLeaf()) {
+			nodes[n].bounds = nodes[n + 1].bounds;
+			nodes[n].bounds.expand(nodes[nodes[n].secondChild].bounds);
+		}
+	}
+	return interiorCost() <= MAX_REFIT_GROWTH * builtCost;
+}
+
+/**
+ * @fn	template <class T> double CompiledSceneT<T>::interiorCost() const
+ * @brief	Summed surface area of the interior boxes. Proportional to the
+ * 			expected number of boxes a ray visits, so it measures how much the
+ * 			hierarchy has degraded since it was built.
+ * @return	The cost.
+ */
+
+template <class T>
+double CompiledSceneT<T>::interiorCost() const {
+	double cost = 0.0;
+	for (const BVHNodeT<T>& node : nodes) {
+		if (!node.isLeaf()) {
+			cost += node.bounds.surfaceArea();
+		}
+	}
+	return cost;
+}
+
+/**
+ * @fn	template <class T> int CompiledSceneT<T>::getNumPrimitives() const
+ * @brief	Number of primitives the objects were split into.
+ * @return	The number of primitives.
+ */
+
+template <class T>
+int CompiledSceneT<T>::getNumPrimitives() const {
+	return quadrics.size() + alignedQuadrics.size() + sphericalQuadrics.size() + cylinders.size() + cones.size() + spheres.size() +
+		planes.size() + disks.size() + triangles.size() + others.size();
+}
+
+/**
+ * @fn	template <class T> template <int FORM, class Visit> bool CompiledSceneT<T>::scanQuadrics(const QuadricGroup<T>& group, const ShapeRun& run, const RayT<T>& ray, bool skipDielectrics, Visit visit) const
+ * @brief	scanRun for a run of unclipped quadrics of one form.
+ */
+
+template <class T>
+template <int FORM, class Visit>
+bool CompiledSceneT<T>::scanQuadrics(const QuadricGroup<T>& group, const ShapeRun& run, const RayT<T>& ray,
+									bool skipDielectrics, Visit visit) const {
+	for (int i = run.begin; i < run.end; i++) {
+		if (skipDielectrics && !blocksLight[group.owner[i]]) continue;
+		T t = quadricClosestT<FORM>(group.params(i), group.center(i), ray);
+		if (visit(group.owner[i], group.part[i], t)) return true;
+	}
+	return false;
+}
+
+/**
+ * @fn	template <class T> template <class Visit> bool CompiledSceneT<T>::scanRun(const ShapeRun& run, const RayT<T>& ray, bool skipDielectrics, Visit visit) const
+ * @brief	Intersects a ray with every primitive of a run and calls
+ * 			visit(owner, part, t) for each; t is FLT_MAX for a miss. Stops early if
+ * 			visit returns true. Shapes of OTHER_SHAPE kind are tested in double
+ * 			precision whatever T is.
+ * @param	run			   	The run.
+ * @param	ray			   	The ray.
+ * @param	skipDielectrics	If true, primitives of dielectric objects are skipped.
+ * @param	visit		   	Called for each primitive tested.
+ * @return	True iff visit asked to stop.
+ */
+
+template <class T>
+template <class Visit>
+bool CompiledSceneT<T>::scanRun(const ShapeRun& run, const RayT<T>& ray, bool skipDielectrics, Visit visit) const {
+	switch (run.kind) {
+	case QUADRIC_SHAPE:
+		return scanQuadrics<GENERAL_QUADRIC>(quadrics, run, ray, skipDielectrics, visit);
+	case ALIGNED_QUADRIC_SHAPE:
+		return scanQuadrics<AXIS_ALIGNED_QUADRIC>(alignedQuadrics, run, ray, skipDielectrics, visit);
+	case SPHERICAL_QUADRIC_SHAPE:
+		return scanQuadrics<SPHERICAL_QUADRIC>(sphericalQuadrics, run, ray, skipDielectrics, visit);
+	case CYLINDER_Y_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			if (skipDielectrics && !blocksLight[cylinders.owner[i]]) continue;
+			T t = cylinderYClosestT(cylinders.params(i), cylinders.center(i),
+										 cylinders.yLo[i], cylinders.yHi[i], ray);
+			if (visit(cylinders.owner[i], cylinders.part[i], t)) return true;
+		}
+		break;
+	case CONE_Y_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			if (skipDielectrics && !blocksLight[cones.owner[i]]) continue;
+			T t = coneYClosestT(cones.params(i), cones.center(i), cones.yLo[i], cones.yHi[i], ray);
+			if (visit(cones.owner[i], cones.part[i], t)) return true;
+		}
+		break;
+	case GEOMETRIC_SPHERE_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			if (skipDielectrics && !blocksLight[spheres.owner[i]]) continue;
+			T t = geometricSphereClosestT(spheres.center(i), spheres.radius[i], ray);
+			if (visit(spheres.owner[i], spheres.part[i], t)) return true;
+		}
+		break;
+	case PLANE_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			if (skipDielectrics && !blocksLight[planes.owner[i]]) continue;
+			T t = planeClosestT(planes.point(i), planes.normal(i), ray);
+			if (visit(planes.owner[i], planes.part[i], t)) return true;
+		}
+		break;
+	case DISK_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			if (skipDielectrics && !blocksLight[disks.owner[i]]) continue;
+			T t = diskClosestT(disks.center(i), disks.normal(i), disks.radius[i], ray);
+			if (visit(disks.owner[i], disks.part[i], t)) return true;
+		}
+		break;
+	case TRIANGLE_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			if (skipDielectrics && !blocksLight[triangles.owner[i]]) continue;
+			T t = triangleClosestT(triangles.get(i), ray);
+			if (visit(triangles.owner[i], triangles.part[i], t)) return true;
+		}
+		break;
+	default:
+		for (int i = run.begin; i < run.end; i++) {
+			if (skipDielectrics && !blocksLight[others.owner[i]]) continue;
+			int part;
+			double t = others.shapes[i]->closestT(Ray(ray), part);
+			if (visit(others.owner[i], part, t)) return true;
+		}
+		break;
+	}
+	return false;
+}
+
+/**
+ * @fn	template <class T> static T toPrecision(double x)
+ * @brief	Converts a distance to precision T, saturating instead of overflowing.
+ * @param	x	The distance.
+ * @return	x, as a T.
+ */
+
+template <class T>
+static T toPrecision(double x) {
+	return x < std::numeric_limits<T>::max() ? (T)x : std::numeric_limits<T>::max();
+}
+
+/**
+ * @fn	template <class T> bool CompiledSceneT<T>::findClosestPrimitive(const RayT<T>& ray, T tMax, int& owner, int& part, T& t) const
+ * @brief	Finds the closest primitive a ray hits before tMax, without building a
+ * 			hit record.
+ * @param 		  	ray  	The ray.
+ * @param 		  	tMax 	Hits at or beyond this distance are ignored.
+ * @param [out]		owner	Index of the object hit (see getObject).
+ * @param [out]		part 	Which part of it was hit.
+ * @param [out]		t	 	Distance to the hit.
+ * @return	True iff something was hit.
+ */
+
+template <class T>
+bool CompiledSceneT<T>::findClosestPrimitive(const RayT<T>& ray, T tMax, int& owner, int& part, T& t) const {
+	int closestOwner = -1;
+	int closestPart = 0;
+	T tClosest = tMax;
+	auto consider = [&](int hitOwner, int hitPart, T tHit) {
+		if (tHit < tClosest && tHit != FLT_MAX) {
+			tClosest = tHit;
+			closestOwner = hitOwner;
+			closestPart = hitPart;
+		}
+		return false;
+	};
+
+	for (int r = 0; r < numUnboundedRuns; r++) {
+		scanRun(runs[r], ray, false, consider);
+	}
+	T tLimit = tClosest;
+	BVH::traverse(nodes, ray.origin, inverseDirection(ray.dir), tLimit,
+		[&](int start, int count, T& tCull) {
+			for (int r = start; r < start + count; r++) {
+				scanRun(runs[r], ray, false, consider);
+			}
+			tCull = tClosest;
+			return false;
+		});
+
+	owner = closestOwner;
+	part = closestPart;
+	t = tClosest;
+	return closestOwner >= 0;
+}
+
+/**
+ * @fn	template <class T> void CompiledSceneT<T>::findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const
+ * @brief	Finds the closest intersection of a ray with the objects. Leaves hit
+ * 			alone unless something closer than hit.t is found.
+ * @param 		  	ray	The ray.
+ * @param [in,out]	hit	The closest hit.
+ */
+
+template <class T>
+void CompiledSceneT<T>::findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const {
+	int owner, part;
+	T t;
+	if (findClosestPrimitive(RayT<T>(ray), toPrecision<T>(hit.t), owner, part, t)) {
+		objects[owner]->resolveHit(ray, t, part, hit);
+	}
+}
+
+/**
+ * @fn	template <class T> bool CompiledSceneT<T>::occluded(const Ray& ray, double tMax) const
+ * @brief	Any-hit query: determines whether some non-dielectric object is hit
+ * 			closer than tMax. Stops at the first blocker found.
+ * @param	ray 	The shadow feeler.
+ * @param	tMax	Distance to the light.
+ * @return	True iff the ray is blocked.
+ */
+
+template <class T>
+bool CompiledSceneT<T>::occluded(const Ray& ray, double tMax) const {
+	RayT<T> feeler(ray);
+	auto blocks = [&](int, int, T t) {
+		return t < tMax;
+	};
+	for (int r = 0; r < numUnboundedRuns; r++) {
+		if (scanRun(runs[r], feeler, true, blocks)) {
+			return true;
+		}
+	}
+
+	bool blocked = false;
+	T tLimit = toPrecision<T>(tMax);
+	BVH::traverse(nodes, feeler.origin, inverseDirection(feeler.dir), tLimit,
+		[&](int start, int count, T&) {
+			for (int r = start; r < start + count; r++) {
+				if (scanRun(runs[r], feeler, true, blocks)) {
+					blocked = true;
+					return true;
+				}
+			}
+			return false;
+		});
+	return blocked;
+}
+
+/**
+ * @fn	template <> void CompiledSceneT<double>::scanRunPacket(const ShapeRun& run, const RayPacket& packet, VisibleIShapePtr closest[], double tClosest[]) const
+ * @brief	Intersects a packet with every primitive of a run, keeping the closest
+ * 			object per lane. Kinds without a vectorized test go one ray at a time.
+ * @param 		  	run			The run.
+ * @param 		  	packet  	The rays.
+ * @param [in,out]	closest 	Per-lane closest object.
+ * @param [in,out]	tClosest	Per-lane t of the closest object.
+ */
+
+template <>
+void CompiledSceneT<double>::scanRunPacket(const ShapeRun& run, const RayPacket& packet,
+										VisibleIShapePtr closest[], double tClosest[]) const {
+	alignas(32) double t[PACKET_SIZE];
+	auto update = [&](int owner) {
+		for (int lane = 0; lane < PACKET_SIZE; lane++) {
+			if ((packet.activeLanes & (1 << lane)) && t[lane] < tClosest[lane] && t[lane] != FLT_MAX) {
+				tClosest[lane] = t[lane];
+				closest[lane] = objects[owner];
+			}
+		}
+	};
+
+	switch (run.kind) {
+	case QUADRIC_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			quadricIntersectPacket<GENERAL_QUADRIC>(quadrics.params(i), quadrics.center(i), packet, t);
+			update(quadrics.owner[i]);
+		}
+		break;
+	case ALIGNED_QUADRIC_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			quadricIntersectPacket<AXIS_ALIGNED_QUADRIC>(alignedQuadrics.params(i), alignedQuadrics.center(i), packet, t);
+			update(alignedQuadrics.owner[i]);
+		}
+		break;
+	case SPHERICAL_QUADRIC_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			quadricIntersectPacket<SPHERICAL_QUADRIC>(sphericalQuadrics.params(i), sphericalQuadrics.center(i), packet, t);
+			update(sphericalQuadrics.owner[i]);
+		}
+		break;
+	case GEOMETRIC_SPHERE_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			geometricSphereIntersectPacket(spheres.center(i), spheres.radius[i], packet, t);
+			update(spheres.owner[i]);
+		}
+		break;
+	case PLANE_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			planeIntersectPacket(planes.point(i), planes.normal(i), packet, t);
+			update(planes.owner[i]);
+		}
+		break;
+	case DISK_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			diskIntersectPacket(disks.center(i), disks.normal(i), disks.radius[i], packet, t);
+			update(disks.owner[i]);
+		}
+		break;
+	case TRIANGLE_SHAPE:
+		for (int i = run.begin; i < run.end; i++) {
+			triangleIntersectPacket(triangles.get(i), packet, t);
+			update(triangles.owner[i]);
+		}
+		break;
+	default:
+		for (int lane = 0; lane < PACKET_SIZE; lane++) {
+			if ((packet.activeLanes & (1 << lane)) == 0) {
+				continue;
+			}
+			scanRun(run, packet.getRay(lane), false, [&](int owner, int, double tHit) {
+				if (tHit < tClosest[lane] && tHit != FLT_MAX) {
+					tClosest[lane] = tHit;
+					closest[lane] = objects[owner];
+				}
+				return false;
+			});
+		}
+		break;
+	}
+}
+
+/**
+ * @fn	template <> void CompiledSceneT<double>::findClosestIntersections(const RayPacket& packet, VisibleIShapePtr closest[], double tClosest[]) const
+ * @brief	Finds the closest object hit by each ray of a packet. A node is visited if
+ * 			any ray of the packet hits it.
+ * @param 		  	packet  	The rays.
+ * @param [out]		closest 	Per-lane closest object, nullptr if none.
+ * @param [out]		tClosest	Per-lane t of the closest object, FLT_MAX if none.
+ */
+
+template <>
+void CompiledSceneT<double>::findClosestIntersections(const RayPacket& packet, VisibleIShapePtr closest[],
+													double tClosest[]) const {
+	for (int i = 0; i < PACKET_SIZE; i++) {
+		closest[i] = nullptr;
+		tClosest[i] = FLT_MAX;
+	}
+	for (int r = 0; r < numUnboundedRuns; r++) {
+		scanRunPacket(runs[r], packet, closest, tClosest);
+	}
+	if (nodes.empty()) {
+		return;
+	}
+
+	const int STACK_SIZE = 64;
+	int stack[STACK_SIZE];
+	int top = 0;
+	alignas(32) double tEnter[PACKET_SIZE];
+	if (nodes[0].bounds.intersect(packet, tClosest, tEnter) == 0) {
+		return;
+	}
+	stack[top++] = 0;
+	while (top > 0) {
+		const BVHNode& node = nodes[stack[--top]];
+		if (node.isLeaf()) {
+			for (int r = node.start; r < node.start + node.count; r++) {
+				scanRunPacket(runs[r], packet, closest, tClosest);
+			}
+			continue;
+		}
+		int first = (int)(&node - &nodes[0]) + 1;
+		int second = node.secondChild;
+		alignas(32) double tFirst[PACKET_SIZE];
+		alignas(32) double tSecond[PACKET_SIZE];
+		int hitFirst = nodes[first].bounds.intersect(packet, tClosest, tFirst);
+		int hitSecond = nodes[second].bounds.intersect(packet, tClosest, tSecond);
+		if (hitFirst && hitSecond) {
+			// Order the children by where the first ray that hits both enters them.
+			int lane = 0;
+			while (((hitFirst & hitSecond) & (1 << lane)) == 0 && lane < PACKET_SIZE - 1) {
+				lane++;
+			}
+			if (tFirst[lane] < tSecond[lane]) {
+				stack[top++] = second;
+				stack[top++] = first;
+			} else {
+				stack[top++] = first;
+				stack[top++] = second;
+			}
+		} else if (hitFirst) {
+			stack[top++] = first;
+		} else if (hitSecond) {
+			stack[top++] = second;
+		}
+	}
+}
+
+template class CompiledSceneT<double>;
+template class CompiledSceneT<float>;
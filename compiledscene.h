@@ -0,0 +1,247 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <vector>
+#include "defs.h"
+#include "ishape.h"
+#include "bvh.h"
+#include "shapekernels.h"
+
+/**
+ * @enum	SHAPE_KIND
+ * @brief	The concrete kinds of primitive a CompiledScene stores. Clipped cylinders
+ * 			and cones come before disks so that, within a leaf, a closed cylinder's
+ * 			side wins ties against its caps (as it does in IClosedCylinderY).
+ */
+
+enum SHAPE_KIND {
+	QUADRIC_SHAPE,			//!< unclipped quadric of GENERAL_QUADRIC form
+	ALIGNED_QUADRIC_SHAPE,	//!< unclipped quadric of AXIS_ALIGNED_QUADRIC form (ellipsoids, ...)
+	SPHERICAL_QUADRIC_SHAPE,	//!< unclipped quadric of SPHERICAL_QUADRIC form
+	CYLINDER_Y_SHAPE,		//!< side of an ICylinderY
+	CONE_Y_SHAPE,			//!< side of an IConeY
+	GEOMETRIC_SPHERE_SHAPE,
+	PLANE_SHAPE,
+	DISK_SHAPE,				//!< disks, including the caps of closed cylinders/cones
+	TRIANGLE_SHAPE,
+	OTHER_SHAPE,			//!< anything else; tested through IShape
+	NUM_SHAPE_KINDS
+};
+
+/**
+ * @struct	ShapeGroup
+ * @brief	Base of the per-kind primitive arrays: which object (and which part of
+ * 			it) each primitive came from.
+ */
+
+struct ShapeGroup {
+	vector<int> owner;		//!< index of the object this primitive belongs to
+	vector<int> part;		//!< which part of the object it is (see IShape::closestT)
+	int size() const { return (int)owner.size(); }
+	void clear() { owner.clear(); part.clear(); }
+};
+
+/**
+ * @struct	QuadricGroup
+ * @brief	Quadric surfaces, in structure-of-arrays layout. Also holds the sides
+ * 			of clipped cylinders and cones, which are clipped to [yLo, yHi].
+ */
+
+template <class T>
+struct QuadricGroup : ShapeGroup {
+	vector<T> cx, cy, cz;					//!< centers
+	vector<T> A, B, C, D, E, F, G, H, I, J;	//!< quadric parameters
+	vector<T> yLo, yHi;						//!< clipping heights (clipped kinds only)
+	void add(int owner, int part, const IQuadricSurface& q, double yLo = 0.0, double yHi = 0.0);
+	QuadricCoefficients<T> params(int i) const {
+		return { A[i], B[i], C[i], D[i], E[i], F[i], G[i], H[i], I[i], J[i] };
+	}
+	glm::tvec3<T> center(int i) const { return glm::tvec3<T>(cx[i], cy[i], cz[i]); }
+	void clear();
+};
+
+/**
+ * @struct	PlaneGroup
+ * @brief	Planes, in structure-of-arrays layout.
+ */
+
+template <class T>
+struct PlaneGroup : ShapeGroup {
+	vector<T> ax, ay, az;		//!< points on the planes
+	vector<T> nx, ny, nz;		//!< unit normals
+	void add(int owner, int part, const IPlane& plane);
+	glm::tvec3<T> point(int i) const { return glm::tvec3<T>(ax[i], ay[i], az[i]); }
+	glm::tvec3<T> normal(int i) const { return glm::tvec3<T>(nx[i], ny[i], nz[i]); }
+	void clear();
+};
+
+/**
+ * @struct	DiskGroup
+ * @brief	Disks, in structure-of-arrays layout.
+ */
+
+template <class T>
+struct DiskGroup : ShapeGroup {
+	vector<T> cx, cy, cz;		//!< centers
+	vector<T> nx, ny, nz;		//!< unit normals
+	vector<T> radius;
+	void add(int owner, int part, const IDisk& disk);
+	glm::tvec3<T> center(int i) const { return glm::tvec3<T>(cx[i], cy[i], cz[i]); }
+	glm::tvec3<T> normal(int i) const { return glm::tvec3<T>(nx[i], ny[i], nz[i]); }
+	void clear();
+};
+
+/**
+ * @struct	TriangleGroup
+ * @brief	Triangles, in structure-of-arrays layout, with everything the
+ * 			intersection test needs precomputed.
+ */
+
+template <class T>
+struct TriangleGroup : ShapeGroup {
+	vector<T> ax, ay, az;			//!< first vertex
+	vector<T> nx, ny, nz;			//!< unit normal
+	vector<T> e0x, e0y, e0z;		//!< b - a
+	vector<T> e1x, e1y, e1z;		//!< c - a
+	vector<T> d00, d01, d11, denom;
+	void add(int owner, int part, const ITriangle& tri);
+	TriangleDataT<T> get(int i) const;
+	void clear();
+};
+
+/**
+ * @struct	SphereGroup
+ * @brief	Geometric spheres, in structure-of-arrays layout.
+ */
+
+template <class T>
+struct SphereGroup : ShapeGroup {
+	vector<T> cx, cy, cz;		//!< centers
+	vector<T> radius;
+	void add(int owner, int part, const IGeometricSphere& sphere);
+	glm::tvec3<T> center(int i) const { return glm::tvec3<T>(cx[i], cy[i], cz[i]); }
+	void clear();
+};
+
+/**
+ * @struct	OtherGroup
+ * @brief	Shapes of kinds CompiledScene does not know about. These are still
+ * 			intersected through their virtual functions, in double precision.
+ */
+
+struct OtherGroup : ShapeGroup {
+	vector<const IShape*> shapes;
+	void add(int owner, const IShape* shape);
+	void clear();
+};
+
+/**
+ * @struct	ShapeRun
+ * @brief	A range of primitives of one kind: [begin, end) of that kind's group.
+ */
+
+struct ShapeRun {
+	int kind;		//!< a SHAPE_KIND
+	int begin;		//!< first primitive
+	int end;		//!< one past the last primitive
+};
+
+/**
+ * @struct	Primitive
+ * @brief	One primitive, between splitting up the objects and storing it in its
+ * 			group.
+ */
+
+struct Primitive {
+	int kind;				//!< a SHAPE_KIND
+	const IShape* shape;	//!< the shape (or part of a shape) to store
+	int owner;				//!< index of the object it belongs to
+	int part;				//!< which part of the object it is
+};
+
+/**
+ * @class	CompiledSceneT
+ * @brief	The opaque objects of a scene, flattened for ray tracing. Each object is
+ * 			split into primitives (e.g., a closed cylinder becomes a side and two
+ * 			disks), the primitives are grouped by concrete kind into contiguous
+ * 			arrays, and a BVH is built over them. Each BVH leaf is a list of
+ * 			single-kind runs, so the inner loops are tight, type-specific and free of
+ * 			virtual calls. Hit records are built through the original
+ * 			VisibleIShape, once, for the closest hit.
+ *
+ * 			T is the precision the primitives are stored and intersected in.
+ * 			CompiledScene (double) is the reference; CompiledSceneF (float) halves
+ * 			the memory the inner loops stream through, at the cost of t values
+ * 			that are only good to float precision. Its boxes are rounded outward,
+ * 			so it never culls a primitive the double boxes would keep. The packet
+ * 			queries exist in double precision only.
+ *
+ * 			Objects that moved or changed size since the last build can be
+ * 			refit: the hierarchy keeps its shape, the primitives are re-read in
+ * 			place and the boxes are recomputed bottom-up, which is linear in the
+ * 			number of primitives and much cheaper than a build.
+ */
+
+template <class T>
+class CompiledSceneT {
+public:
+	void build(const vector<VisibleIShapePtr>& objects);
+	bool refit(const vector<VisibleIShapePtr>& objects);
+	bool findClosestPrimitive(const RayT<T>& ray, T tMax, int& owner, int& part, T& t) const;
+	void findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const;
+	void findClosestIntersections(const RayPacket& packet, VisibleIShapePtr closest[], double tClosest[]) const;
+	bool occluded(const Ray& ray, double tMax) const;
+	int getNumPrimitives() const;
+	size_t getNumNodes() const { return nodes.size(); }
+	VisibleIShapePtr getObject(int owner) const { return objects[owner]; }
+protected:
+	template <int FORM, class Visit>
+	bool scanQuadrics(const QuadricGroup<T>& group, const ShapeRun& run, const RayT<T>& ray,
+		bool skipDielectrics, Visit visit) const;
+	template <class Visit>
+	bool scanRun(const ShapeRun& run, const RayT<T>& ray, bool skipDielectrics, Visit visit) const;
+	void scanRunPacket(const ShapeRun& run, const RayPacket& packet,
+		VisibleIShapePtr closest[], double tClosest[]) const;
+	void clearGroups();
+	void appendRuns(vector<Primitive>& prims);
+	void storePrimitive(const Primitive& prim);
+	double interiorCost() const;
+
+	vector<VisibleIShapePtr> objects;	//!< the objects, as of the last build
+	vector<const IShape*> shapes;		//!< per object: its shape, as of the last build
+	vector<Primitive> primitives;		//!< every primitive, in the order they were stored
+	double builtCost = 0.0;				//!< interiorCost() right after the last build
+	vector<char> blocksLight;			//!< per object: false for dielectrics
+	vector<BVHNodeT<T>> nodes;			//!< hierarchy; a leaf covers runs [start, start + count)
+	vector<ShapeRun> runs;				//!< runs of every leaf, plus the unbounded runs
+	int numUnboundedRuns = 0;			//!< runs [0, numUnboundedRuns) are tested by every query
+
+	QuadricGroup<T> quadrics;
+	QuadricGroup<T> alignedQuadrics;
+	QuadricGroup<T> sphericalQuadrics;
+	QuadricGroup<T> cylinders;
+	QuadricGroup<T> cones;
+	SphereGroup<T> spheres;
+	PlaneGroup<T> planes;
+	DiskGroup<T> disks;
+	TriangleGroup<T> triangles;
+	OtherGroup others;
+};
+
+typedef CompiledSceneT<double> CompiledScene;
+typedef CompiledSceneT<float> CompiledSceneF;
+
+// The packet queries are defined for double precision only; see compiledscene.cpp.
+template <>
+void CompiledSceneT<double>::findClosestIntersections(const RayPacket& packet, VisibleIShapePtr closest[],
+													double tClosest[]) const;
+template <>
+void CompiledSceneT<double>::scanRunPacket(const ShapeRun& run, const RayPacket& packet,
+										VisibleIShapePtr closest[], double tClosest[]) const;
@@ -15,6 +15,7 @@
 #include "colorandmaterials.h"
 #include "rasterization.h"
 #include "io.h"
+#include "packet.h"
 
 FrameBuffer frameBuffer(WINDOW_WIDTH, WINDOW_HEIGHT);
 
@@ -46,7 +47,7 @@ int main(int argc, char* argv[]) {
 	double a = 5;
 	double b = 6;
 	swap(a, b);
-	int line = 53;
+	int line = 54;
 	double unitX, unitY;
 	pointOnUnitCircle(PI, unitX, unitY);
 	vector<double> quadratic1 = quadratic(1, 4, 3);
@@ -252,6 +253,30 @@ int main(int argc, char* argv[]) {
 	std::cout << "True? " << approximatelyEqual(areaOfTriangle(dvec3(-10.0, -10.0, -10.0), dvec3(-11.0, -10.0, -10.0), dvec3(-10.0, -11.0, -10.0)), 0.5) << "  Result: "
 		<< areaOfTriangle(dvec3(-10.0, -10.0, -10.0), dvec3(-11.0, -10.0, -10.0), dvec3(-10.0, -11.0, -10.0)) << "  Line: " << (line += 3) << std::endl;
 
+	double roots[2];
+	int numRoots1 = quadratic(1, 4, 3, roots);
+	std::cout << "True? " << (numRoots1 == 2 && approximatelyEqual(roots[0], -3) && approximatelyEqual(roots[1], -1)) << "  Line: " << (line += 5) << std::endl;
+
+	int numRoots2 = quadratic(1, 0, 0, roots);
+	std::cout << "True? " << (numRoots2 == 1 && roots[0] == 0) << "  Line: " << (line += 3) << std::endl;
+
+	std::cout << "True? " << (quadratic(-4, -2, -1, roots) == 0) << "  Line: " << (line += 2) << std::endl;
+
+	// The textbook formula gets the small root of x^2 + 1e8 x + 1 wrong by about 25%.
+	int numRoots4 = quadratic(1, 1.0e8, 1, roots);
+	std::cout << "True? " << (numRoots4 == 2 && glm::abs(roots[1] + 1.0e-8) < 1.0e-20) << "  Result: " << roots[1] << "  Line: " << (line += 4) << std::endl;
+
+	alignas(32) double A[PACKET_SIZE] = { 1, 1, -4, 1 };
+	alignas(32) double B[PACKET_SIZE] = { 4, 0, -2, 1.0e8 };
+	alignas(32) double C[PACKET_SIZE] = { 3, 0, -1, 1 };
+	alignas(32) double r0[PACKET_SIZE], r1[PACKET_SIZE];
+	PacketDouble packetR0, packetR1;
+	int hasRoots = quadratic(PacketDouble::load(A), PacketDouble::load(B), PacketDouble::load(C), packetR0, packetR1).bits();
+	packetR0.store(r0);
+	packetR1.store(r1);
+	std::cout << "True? " << (hasRoots == 0xB && approximatelyEqual(r0[0], -3) && approximatelyEqual(r1[0], -1) &&
+		r0[1] == 0 && r1[1] == 0 && r1[3] == roots[1]) << "  Line: " << (line += 10) << std::endl;
+
 
 	return 0;
 }
\ No newline at end of file
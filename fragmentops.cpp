@@ -16,6 +16,7 @@ bool FragmentOps::depthBufferWriteEnabled = true;
 bool FragmentOps::colorBufferWriteEnabled = true;
 bool FragmentOps::textureMappingEnabled = false;
 Image* FragmentOps::textureImage = nullptr;
+TEXTURE_FILTER FragmentOps::textureFilter = TRILINEAR_FILTER;
 
 /**
  * @fn	double FogParams::fogFactor(const dvec3 &fragPos, const dvec3 &eyePos) const
@@ -79,7 +80,7 @@ color FragmentOps::applyBlending(double alpha, const color& srcColor, const colo
 /**
  * @fn	void FragmentOps::processFragment(FrameBuffer &frameBuffer,
  *											const dvec3 &eyePositionInWorldCoords,
- *											const vector<LightSourcePtr> lights,
+ *											const vector<LightSourcePtr> &lights,
  *											const Fragment &fragment,
  *											const dmat4 &viewingMatrix)
  * @brief	Process the fragment, leaving the results in the framebuffer.
@@ -91,7 +92,7 @@ color FragmentOps::applyBlending(double alpha, const color& srcColor, const colo
  */
 
 void FragmentOps::processFragment(FrameBuffer& frameBuffer, const dvec3& eyePositionInWorldCoords,
-    const vector<LightSourcePtr> lights,
+    const vector<LightSourcePtr>& lights,
     const Fragment& fragment,
     const Frame& eyeFrame) {
 
@@ -100,12 +101,20 @@ void FragmentOps::processFragment(FrameBuffer& frameBuffer, const dvec3& eyePosi
     int Y = (int)fragment.windowPos.y;
     DEBUG_PIXEL = (X == xDebug && Y == yDebug);
 
-    if (!performDepthTest || Z < frameBuffer.getDepth(X, Y)) {
+    if (passesDepthTest(frameBuffer, X, Y, Z)) {
+        Material material = fragment.material;
+        if (textureMappingEnabled && textureImage != nullptr) {
+            color texelColor = textureImage->sampleUV(fragment.textCoord.x, fragment.textCoord.y,
+                fragment.textureLOD, textureFilter);
+            material.ambient = 0.15 * texelColor;
+            material.diffuse = texelColor;
+        }
+
         // Compute lighting using built-in illuminate() function
         color litColor = lights[0]->illuminate(
             fragment.worldPos,
             fragment.worldNormal,
-            fragment.material,
+            material,
             eyeFrame,
             false // not in shadow
         );
@@ -121,4 +130,19 @@ void FragmentOps::processFragment(FrameBuffer& frameBuffer, const dvec3& eyePosi
             frameBuffer.setDepth(X, Y, Z);
         }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @fn	bool FragmentOps::passesDepthTest(const FrameBuffer& frameBuffer, int x, int y, double z)
+ * @brief	The depth test processFragment applies. Rasterizers may call it before
+ * 			interpolating the rest of a fragment, to skip hidden fragments early.
+ * @param	frameBuffer	The frame buffer.
+ * @param	x		   	The fragment's column.
+ * @param	y		   	The fragment's row.
+ * @param	z		   	The fragment's depth.
+ * @return	True iff the fragment is to be drawn.
+ */
+
+bool FragmentOps::passesDepthTest(const FrameBuffer& frameBuffer, int x, int y, double z) {
+    return !performDepthTest || z < frameBuffer.getDepth(x, y);
+}
@@ -7,18 +7,25 @@
  * permission is granted.
  ****************************************************/
 
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "defs.h"
 #include "utilities.h"
 #include "framebuffer.h"
+#include "frameexport.h"
 
  /**
-  * @fn	FrameBuffer::FrameBuffer(const int width, const int height)
+  * @fn	FrameBuffer::FrameBuffer(const int width, const int height, FRAMEBUFFER_LAYOUT layout)
   * @brief	Constructor
   * @param	width 	The width.
   * @param	height	The height.
+  * @param	layout	How pixels are arranged in memory.
   */
 
-FrameBuffer::FrameBuffer(const int width, const int height) {
+FrameBuffer::FrameBuffer(const int width, const int height, FRAMEBUFFER_LAYOUT layout)
+	: layout(layout), colorBuffer(nullptr), depthBuffer(nullptr) {
 	setFrameBufferSize(width, height);
 }
 
@@ -43,11 +50,95 @@ FrameBuffer::~FrameBuffer() {
 void FrameBuffer::setFrameBufferSize(int width, int height) {
 	this->width = width;
 	this->height = height;
-	int area = width * height;
+	allocateBuffers();
+}
+
+/**
+ * @fn	void FrameBuffer::setLayout(FRAMEBUFFER_LAYOUT layout)
+ * @brief	Switches between the linear and tiled layouts. The contents are lost.
+ * @param	layout	The new layout.
+ */
+
+void FrameBuffer::setLayout(FRAMEBUFFER_LAYOUT layout) {
+	this->layout = layout;
+	allocateBuffers();
+}
+
+/**
+ * @fn	void FrameBuffer::setAccumulation(bool accumulate)
+ * @brief	Turns the floating point accumulation buffer on or off. The colors
+ * 			are lost.
+ * @param	accumulate	True to keep colors as floats.
+ */
+
+void FrameBuffer::setAccumulation(bool accumulate) {
+	accumBuffer.clear();
+	accumBuffer.shrink_to_fit();
+	if (accumulate) {
+		accumBuffer.assign((size_t)4 * width * height, 0.0f);
+	}
+}
+
+/**
+ * @fn	void FrameBuffer::allocateBuffers()
+ * @brief	Allocates the buffers for the current size and layout. Tiled buffers
+ * 			are padded to whole tiles and start out cleared.
+ */
+
+void FrameBuffer::allocateBuffers() {
+	const int T = FRAMEBUFFER_TILE_SIZE;
+	tilesPerRow = (width + T - 1) / T;
+	numTiles = tilesPerRow * ((height + T - 1) / T);
+	size_t area = layout == TILED_LAYOUT ? (size_t)numTiles * T * T : (size_t)width * height;
 	delete[] colorBuffer;
 	delete[] depthBuffer;
 	colorBuffer = new GLubyte[area * BYTES_PER_PIXEL];
 	depthBuffer = new double[area];
+	colorTileStates.reset();
+	depthTileStates.reset();
+	if (layout == TILED_LAYOUT) {
+		colorTileStates.reset(new std::atomic<unsigned char>[numTiles]);
+		depthTileStates.reset(new std::atomic<unsigned char>[numTiles]);
+		std::memcpy(tileClearColorUB, clearColorUB, BYTES_PER_PIXEL);
+		for (int i = 0; i < numTiles; i++) {
+			colorTileStates[i].store(TILE_CLEARED, std::memory_order_relaxed);
+			depthTileStates[i].store(TILE_CLEARED, std::memory_order_relaxed);
+		}
+	}
+	if (isAccumulating()) {
+		setAccumulation(true);
+	}
+}
+
+/**
+ * @fn	void FrameBuffer::fillClearedTile(std::atomic<unsigned char>& state, int tile, bool isColor)
+ * @brief	Makes a cleared tile's memory valid before a pixel in it is written,
+ * 			by filling it with the clear color or depth. When threads race, one
+ * 			fills and the others wait for it. Called by prepareColorTile and
+ * 			prepareDepthTile when the tile is not already TILE_WRITTEN.
+ * @param [in,out]	state  	The tile's TILE_STATE, in the color or depth buffer.
+ * @param 		  	tile   	The tile.
+ * @param 		  	isColor	True for the color buffer, false for the depth buffer.
+ */
+
+void FrameBuffer::fillClearedTile(std::atomic<unsigned char>& state, int tile, bool isColor) {
+	unsigned char expected = TILE_CLEARED;
+	if (state.compare_exchange_strong(expected, TILE_FILLING, std::memory_order_acquire)) {
+		const int AREA = FRAMEBUFFER_TILE_SIZE * FRAMEBUFFER_TILE_SIZE;
+		if (isColor) {
+			GLubyte* pixels = colorBuffer + (size_t)tile * AREA * BYTES_PER_PIXEL;
+			for (int i = 0; i < AREA; i++) {
+				std::memcpy(pixels + i * BYTES_PER_PIXEL, tileClearColorUB, BYTES_PER_PIXEL);
+			}
+		} else {
+			std::fill(depthBuffer + (size_t)tile * AREA, depthBuffer + (size_t)(tile + 1) * AREA, 1.0);
+		}
+		state.store(TILE_WRITTEN, std::memory_order_release);
+		return;
+	}
+	while (state.load(std::memory_order_acquire) != TILE_WRITTEN) {
+		std::this_thread::yield();
+	}
 }
 
 /**
@@ -75,37 +166,188 @@ void FrameBuffer::clearColorAndDepthBuffers() {
 
 /**
  * @fn	void FrameBuffer::clearColorBuffer()
- * @brief	Clears the color buffer
+ * @brief	Clears the color buffer. A tiled buffer only marks its tiles cleared.
  */
 
 void FrameBuffer::clearColorBuffer() {
-	for (int y = 0; y < height; ++y) {		// can be made faster
-		for (int x = 0; x < width; ++x) {
-			std::memcpy(colorBuffer + BYTES_PER_PIXEL * (x + y * width),
-											clearColorUB, BYTES_PER_PIXEL);
+	if (isAccumulating()) {
+		for (size_t i = 0; i < accumBuffer.size(); i += 4) {
+			accumBuffer[i] = (float)clearColor.r;
+			accumBuffer[i + 1] = (float)clearColor.g;
+			accumBuffer[i + 2] = (float)clearColor.b;
+			accumBuffer[i + 3] = 0.0f;
 		}
+		return;
+	}
+	if (layout == TILED_LAYOUT) {
+		std::memcpy(tileClearColorUB, clearColorUB, BYTES_PER_PIXEL);
+		for (int i = 0; i < numTiles; i++) {
+			colorTileStates[i].store(TILE_CLEARED, std::memory_order_relaxed);
+		}
+		return;
+	}
+	// Fill the first row, then copy it to the others.
+	const size_t rowBytes = (size_t)width * BYTES_PER_PIXEL;
+	for (int x = 0; x < width; ++x) {
+		std::memcpy(colorBuffer + BYTES_PER_PIXEL * x, clearColorUB, BYTES_PER_PIXEL);
+	}
+	for (int y = 1; y < height; ++y) {
+		std::memcpy(colorBuffer + y * rowBytes, colorBuffer, rowBytes);
 	}
 }
 
 /**
  * @fn	void FrameBuffer::clearDepthBuffer()
- * @brief	Clears the depth buffer
+ * @brief	Clears the depth buffer. A tiled buffer only marks its tiles cleared.
  */
 
 void FrameBuffer::clearDepthBuffer() {
+	if (layout == TILED_LAYOUT) {
+		for (int i = 0; i < numTiles; i++) {
+			depthTileStates[i].store(TILE_CLEARED, std::memory_order_relaxed);
+		}
+		return;
+	}
 	int area = width * height;
 	const int SZ = area;
 	std::fill(depthBuffer, depthBuffer + SZ, 1.0);
 }
+
+/**
+ * @fn	void FrameBuffer::resolveAccumulation(GLubyte* out) const
+ * @brief	Converts the accumulated colors to bytes: scales them by accumScale,
+ * 			clamps them to [0, 1] and truncates, as setColor does. Uses SSE2,
+ * 			four pixels at a time, when the compiler targets it.
+ * @param [out]	out	Row major RGB bytes, width * height of them.
+ */
+
+void FrameBuffer::resolveAccumulation(GLubyte* out) const {
+	const size_t numPixels = (size_t)width * height;
+	const float* in = accumBuffer.data();
+	size_t i = 0;
+#ifdef __SSE2__
+	const __m128 scale = _mm_set1_ps(accumScale);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 maxByte = _mm_set1_ps(255.0f);
+	for (; i + 4 <= numPixels; i += 4) {
+		__m128i ints[4];
+		for (int j = 0; j < 4; j++) {
+			__m128 c = _mm_mul_ps(_mm_loadu_ps(in + 4 * (i + j)), scale);
+			c = _mm_min_ps(_mm_max_ps(c, zero), one);
+			ints[j] = _mm_cvttps_epi32(_mm_mul_ps(c, maxByte));
+		}
+		__m128i shorts01 = _mm_packs_epi32(ints[0], ints[1]);
+		__m128i shorts23 = _mm_packs_epi32(ints[2], ints[3]);
+		alignas(16) GLubyte rgba[16];
+		_mm_store_si128((__m128i*)rgba, _mm_packus_epi16(shorts01, shorts23));
+		for (int j = 0; j < 4; j++) {
+			std::memcpy(out + BYTES_PER_PIXEL * (i + j), rgba + 4 * j, BYTES_PER_PIXEL);
+		}
+	}
+#endif
+	for (; i < numPixels; i++) {
+		for (int k = 0; k < BYTES_PER_PIXEL; k++) {
+			float c = glm::clamp(in[4 * i + k] * accumScale, 0.0f, 1.0f);
+			out[BYTES_PER_PIXEL * i + k] = (GLubyte)(c * 255.0f);
+		}
+	}
+}
+
+/**
+ * @fn	const GLubyte* FrameBuffer::linearColorBuffer() const
+ * @brief	The colors as row major RGB bytes, for OpenGL or a file. A linear
+ * 			buffer is returned as is; accumulated or tiled colors are first
+ * 			assembled in presentBuffer.
+ * @return	width * height pixels, bottom row first.
+ */
+
+const GLubyte* FrameBuffer::linearColorBuffer() const {
+	if (!isAccumulating() && layout == LINEAR_LAYOUT) {
+		return colorBuffer;
+	}
+	presentBuffer.resize((size_t)width * height * BYTES_PER_PIXEL);
+	if (isAccumulating()) {
+		resolveAccumulation(presentBuffer.data());
+		return presentBuffer.data();
+	}
+	const int T = FRAMEBUFFER_TILE_SIZE;
+	for (int y = 0; y < height; y++) {
+		GLubyte* row = presentBuffer.data() + (size_t)y * width * BYTES_PER_PIXEL;
+		for (int x0 = 0; x0 < width; x0 += T) {
+			int n = std::min(T, width - x0);
+			int tile = tileIndex(x0, y);
+			if (colorTileStates[tile].load(std::memory_order_acquire) == TILE_WRITTEN) {
+				std::memcpy(row + x0 * BYTES_PER_PIXEL, colorBuffer + pixelIndex(x0, y) * BYTES_PER_PIXEL,
+							n * BYTES_PER_PIXEL);
+			} else {
+				for (int x = x0; x < x0 + n; x++) {
+					std::memcpy(row + x * BYTES_PER_PIXEL, tileClearColorUB, BYTES_PER_PIXEL);
+				}
+			}
+		}
+	}
+	return presentBuffer.data();
+}
+
 /**
  * @fn	void FrameBuffer::showColorBuffer() const
  * @brief	Shows the contents of the color buffer to screen.
  */
 
 void FrameBuffer::showColorBuffer() const {
+#ifndef CONSOLE_ONLY
 	glRasterPos2d(-1, -1);
-	glDrawPixels(width, height, GL_RGB, GL_UNSIGNED_BYTE, colorBuffer);
+	glDrawPixels(width, height, GL_RGB, GL_UNSIGNED_BYTE, linearColorBuffer());
 	glFlush();
+#endif
+}
+
+/**
+ * @fn	bool FrameBuffer::saveAsPPM(const std::string& filename) const
+ * @brief	Writes the color buffer to a binary (P6) PPM file, and waits until it
+ * 			is written. FrameExporter writes in the background instead.
+ * @param	filename	Name of the file to create.
+ * @return	True iff the file was written successfully.
+ */
+
+bool FrameBuffer::saveAsPPM(const std::string& filename) const {
+	return writePPM(filename, width, height, linearColorBuffer());
+}
+
+/**
+ * @fn	void FrameBuffer::getColorBytes(std::vector<GLubyte>& rgb) const
+ * @brief	Copies the colors, as shown on screen.
+ * @param [out]	rgb	Row major RGB bytes, bottom row first.
+ */
+
+void FrameBuffer::getColorBytes(std::vector<GLubyte>& rgb) const {
+	const GLubyte* pixels = linearColorBuffer();
+	rgb.assign(pixels, pixels + (size_t)width * height * BYTES_PER_PIXEL);
+}
+
+/**
+ * @fn	void FrameBuffer::getColorFloats(std::vector<float>& rgb) const
+ * @brief	Copies the colors as floats. Accumulated colors are scaled but not
+ * 			clamped; 8-bit colors are mapped to [0, 1].
+ * @param [out]	rgb	Row major RGB floats, bottom row first.
+ */
+
+void FrameBuffer::getColorFloats(std::vector<float>& rgb) const {
+	const size_t numPixels = (size_t)width * height;
+	rgb.resize(3 * numPixels);
+	if (isAccumulating()) {
+		for (size_t i = 0; i < numPixels; i++) {
+			for (int k = 0; k < 3; k++) {
+				rgb[3 * i + k] = accumBuffer[4 * i + k] * accumScale;
+			}
+		}
+		return;
+	}
+	const GLubyte* pixels = linearColorBuffer();
+	for (size_t i = 0; i < 3 * numPixels; i++) {
+		rgb[i] = pixels[i] / 255.0f;
+	}
 }
 
 /**
@@ -130,13 +372,43 @@ void FrameBuffer::setColor(int x, int y, const color& rgb) {
 		return;
 	}
 
+	if (isAccumulating()) {
+		float* c = &accumBuffer[4 * ((size_t)y * width + x)];
+		c[0] = (float)rgb.r;
+		c[1] = (float)rgb.g;
+		c[2] = (float)rgb.b;
+		return;
+	}
+
 	color clampedColor = glm::clamp(rgb, 0.0, 1.0);
 
 	GLubyte c[] = { (GLubyte)(clampedColor.r * 255),
 					(GLubyte)(clampedColor.g * 255),
 					(GLubyte)(clampedColor.b * 255) };
 
-	std::memcpy(colorBuffer + BYTES_PER_PIXEL * (x + y * width), c, BYTES_PER_PIXEL);
+	if (layout == TILED_LAYOUT) {
+		prepareColorTile(tileIndex(x, y));
+	}
+	std::memcpy(colorBuffer + BYTES_PER_PIXEL * pixelIndex(x, y), c, BYTES_PER_PIXEL);
+}
+
+/**
+ * @fn	void FrameBuffer::addColor(int x, int y, const color& rgb)
+ * @brief	Adds a color to the one accumulated at (x, y). Does nothing unless
+ * 			accumulation is on.
+ * @param	x  	The x coordinate.
+ * @param	y  	The y coordinate.
+ * @param	rgb	The color to add.
+ */
+
+void FrameBuffer::addColor(int x, int y, const color& rgb) {
+	if (!isAccumulating() || !checkInWindow(x, y)) {
+		return;
+	}
+	float* c = &accumBuffer[4 * ((size_t)y * width + x)];
+	c[0] += (float)rgb.r;
+	c[1] += (float)rgb.g;
+	c[2] += (float)rgb.b;
 }
 
 /**
@@ -150,11 +422,19 @@ void FrameBuffer::setColor(int x, int y, const color& rgb) {
 color FrameBuffer::getColor(int x, int y) const {
 	double red, green, blue;
 
-	if (checkInWindow(x, y)) {
+	if (checkInWindow(x, y) && isAccumulating()) {
+		const float* c = &accumBuffer[4 * ((size_t)y * width + x)];
+		return (double)accumScale * color(c[0], c[1], c[2]);
+	} else if (checkInWindow(x, y)) {
 		GLubyte c[BYTES_PER_PIXEL];
 
 		// Retrieve color values from the color buffer
-		std::memcpy(c, colorBuffer + BYTES_PER_PIXEL * (x + y * width), BYTES_PER_PIXEL);
+		if (layout == TILED_LAYOUT &&
+			colorTileStates[tileIndex(x, y)].load(std::memory_order_acquire) != TILE_WRITTEN) {
+			std::memcpy(c, tileClearColorUB, BYTES_PER_PIXEL);
+		} else {
+			std::memcpy(c, colorBuffer + BYTES_PER_PIXEL * pixelIndex(x, y), BYTES_PER_PIXEL);
+		}
 
 		// Convert individual color components back to double values
 		red = c[0] / 255.0;
@@ -190,7 +470,10 @@ void FrameBuffer::setDepth(double x, double y, double depth) {
 
 void FrameBuffer::setDepth(int x, int y, double depth) {
 	if (checkInWindow(x, y)) {
-		depthBuffer[y * width + x] = depth;
+		if (layout == TILED_LAYOUT) {
+			prepareDepthTile(tileIndex(x, y));
+		}
+		depthBuffer[pixelIndex(x, y)] = depth;
 	}
 }
 
@@ -204,7 +487,11 @@ void FrameBuffer::setDepth(int x, int y, double depth) {
 
 double FrameBuffer::getDepth(int x, int y) const {
 	if (checkInWindow(x, y)) {
-		return depthBuffer[y * width + x];
+		if (layout == TILED_LAYOUT &&
+			depthTileStates[tileIndex(x, y)].load(std::memory_order_acquire) != TILE_WRITTEN) {
+			return 1.0;
+		}
+		return depthBuffer[pixelIndex(x, y)];
 	} else {
 		return 0.0;
 	}
@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <vector>
 #include "defs.h"
 #include "ishape.h"
 #include "colorandmaterials.h"
@@ -18,20 +21,47 @@
 #endif
 
 const int BYTES_PER_PIXEL = 3;			//!< RGB requires 3 bytes.
+const int FRAMEBUFFER_TILE_SHIFT = 4;	//!< log2 of FRAMEBUFFER_TILE_SIZE
+const int FRAMEBUFFER_TILE_SIZE = 1 << FRAMEBUFFER_TILE_SHIFT;	//!< width and height of a tile in the tiled layout
+
+/**
+ * @enum	FRAMEBUFFER_LAYOUT
+ * @brief	How a framebuffer arranges its pixels in memory.
+ */
+
+enum FRAMEBUFFER_LAYOUT {
+	LINEAR_LAYOUT,	//!< one row after another, as OpenGL and PPM files expect
+	TILED_LAYOUT	//!< FRAMEBUFFER_TILE_SIZE squares, each cleared lazily
+};
 
 /**
  * @struct	FrameBuffer
  * @brief	Represents a framebuffer. Two identically sized 2D arrays. The color
  * 			buffer stores the colors and the depth buffer stores the corresponding
  * 			depth at each pixel.
+ *
+ * 			In TILED_LAYOUT each tile is stored contiguously and has a flag per
+ * 			buffer saying it was cleared, so a clear only sets the flags; a tile is
+ * 			filled with the clear value when it is first written. Several threads
+ * 			may write to the same tile, as long as they write different pixels.
+ *
+ * 			With accumulation on, colors are kept as unclamped floats instead of
+ * 			bytes. They can be summed (addColor), and are scaled, clamped and
+ * 			converted to bytes in one pass when the image is shown or saved.
  */
 
 struct FrameBuffer {
-	FrameBuffer(const int width, const int height);
+	FrameBuffer(const int width, const int height, FRAMEBUFFER_LAYOUT layout = LINEAR_LAYOUT);
 	~FrameBuffer();
 	void setFrameBufferSize(int width, int height);
+	void setLayout(FRAMEBUFFER_LAYOUT layout);
+	FRAMEBUFFER_LAYOUT getLayout() const { return layout; }
+	void setAccumulation(bool accumulate);
+	bool isAccumulating() const { return !accumBuffer.empty(); }
+	void setAccumulationScale(double scale) { accumScale = (float)scale; }
 	void setClearColor(const color& clearColor);
 	void setColor(int x, int y, const color& C);
+	void addColor(int x, int y, const color& C);
 	color getClearColor();
 	color getColor(int x, int y) const;
 
@@ -39,6 +69,9 @@ struct FrameBuffer {
 	void clearColorBuffer();
 	void clearDepthBuffer();
 	void showColorBuffer() const;
+	bool saveAsPPM(const std::string& filename) const;
+	void getColorBytes(std::vector<GLubyte>& rgb) const;
+	void getColorFloats(std::vector<float>& rgb) const;
 	int getWindowWidth() const { return width; }
 	int getWindowHeight() const { return height; }
 
@@ -52,11 +85,54 @@ struct FrameBuffer {
 		const BoundingBoxi& viewport);
 	void setPixel(int x, int y, const color& C, double depth);
 protected:
+	/**
+	 * @enum	TILE_STATE
+	 * @brief	Whether a tile of one buffer holds its pixels or still awaits a clear.
+	 */
+
+	enum TILE_STATE : unsigned char {
+		TILE_WRITTEN,	//!< the tile holds its pixels
+		TILE_CLEARED,	//!< every pixel is the clear value; memory not yet filled
+		TILE_FILLING	//!< a thread is filling the tile with the clear value
+	};
+
 	bool checkInWindow(int x, int y) const;
+	void allocateBuffers();
+	int tileIndex(int x, int y) const { return (y >> FRAMEBUFFER_TILE_SHIFT) * tilesPerRow + (x >> FRAMEBUFFER_TILE_SHIFT); }
+	size_t pixelIndex(int x, int y) const {
+		if (layout == LINEAR_LAYOUT) {
+			return (size_t)y * width + x;
+		}
+		const int MASK = FRAMEBUFFER_TILE_SIZE - 1;
+		return ((size_t)tileIndex(x, y) << (2 * FRAMEBUFFER_TILE_SHIFT)) + ((y & MASK) << FRAMEBUFFER_TILE_SHIFT) + (x & MASK);
+	}
+	void prepareColorTile(int tile) {
+		if (colorTileStates[tile].load(std::memory_order_acquire) != TILE_WRITTEN) {
+			fillClearedTile(colorTileStates[tile], tile, true);
+		}
+	}
+	void prepareDepthTile(int tile) {
+		if (depthTileStates[tile].load(std::memory_order_acquire) != TILE_WRITTEN) {
+			fillClearedTile(depthTileStates[tile], tile, false);
+		}
+	}
+	void fillClearedTile(std::atomic<unsigned char>& state, int tile, bool isColor);
+	const GLubyte* linearColorBuffer() const;
+	void resolveAccumulation(GLubyte* out) const;
+
 	int width;								//!< width of framebuffer
 	int height;								//!< height of framebuffer
+	FRAMEBUFFER_LAYOUT layout;				//!< how colorBuffer and depthBuffer are arranged
+	int tilesPerRow;						//!< tiles across, in TILED_LAYOUT
+	int numTiles;							//!< tiles in each buffer, in TILED_LAYOUT
 	GLubyte clearColorUB[BYTES_PER_PIXEL];	//!< Clear color, as unsigned bytes
 	color clearColor;						//!< Clear color
+	GLubyte tileClearColorUB[BYTES_PER_PIXEL];	//!< clear color at the last clear, for cleared tiles
 	GLubyte* colorBuffer;					//!< 2D array for holding colors
 	double* depthBuffer;					//!< 2D array for holding depths
+	std::unique_ptr<std::atomic<unsigned char>[]> colorTileStates;	//!< a TILE_STATE per tile
+	std::unique_ptr<std::atomic<unsigned char>[]> depthTileStates;	//!< a TILE_STATE per tile
+	std::vector<float> accumBuffer;			//!< RGBA floats, row major; empty unless accumulating
+	float accumScale = 1.0f;				//!< accumulated colors are multiplied by this when shown
+	mutable std::vector<GLubyte> presentBuffer;	//!< row major bytes assembled for showing or saving
 };
\ No newline at end of file
@@ -0,0 +1,279 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include "frameexport.h"
+
+/**
+ * @fn	IMAGE_FILE_FORMAT imageFileFormat(const std::string& filename)
+ * @brief	Picks the file format from a file name's extension.
+ * @param	filename	The file name.
+ * @return	PFM_FILE for .pfm files, PPM_FILE otherwise.
+ */
+
+IMAGE_FILE_FORMAT imageFileFormat(const std::string& filename) {
+	size_t dot = filename.rfind('.');
+	if (dot != std::string::npos) {
+		std::string extension = filename.substr(dot + 1);
+		if (extension == "pfm" || extension == "PFM") {
+			return PFM_FILE;
+		}
+	}
+	return PPM_FILE;
+}
+
+/**
+ * @fn	bool writePPM(const std::string& filename, int width, int height, const GLubyte* rgb)
+ * @brief	Writes a binary (P6) PPM file. Row 0 is the bottom of the image, so
+ * 			rows are written in reverse order.
+ * @param	filename	Name of the file to create.
+ * @param	width   	The width.
+ * @param	height  	The height.
+ * @param	rgb			Row major RGB bytes.
+ * @return	True iff the file was written successfully.
+ */
+
+bool writePPM(const std::string& filename, int width, int height, const GLubyte* rgb) {
+	std::ofstream out(filename.c_str(), std::ios::binary);
+	if (!out) {
+		std::cerr << "Unable to open " << filename << " for writing" << endl;
+		return false;
+	}
+	out << "P6\n" << width << " " << height << "\n255\n";
+	const int rowBytes = width * BYTES_PER_PIXEL;
+	for (int y = height - 1; y >= 0; y--) {
+		out.write((const char*)(rgb + y * rowBytes), rowBytes);
+	}
+	return (bool)out;
+}
+
+/**
+ * @fn	bool writePFM(const std::string& filename, int width, int height, const float* rgb)
+ * @brief	Writes a color portable float map. PFM files store the bottom row
+ * 			first, like the framebuffer, and a negative scale marks them little
+ * 			endian.
+ * @param	filename	Name of the file to create.
+ * @param	width   	The width.
+ * @param	height  	The height.
+ * @param	rgb			Row major RGB floats.
+ * @return	True iff the file was written successfully.
+ */
+
+bool writePFM(const std::string& filename, int width, int height, const float* rgb) {
+	std::ofstream out(filename.c_str(), std::ios::binary);
+	if (!out) {
+		std::cerr << "Unable to open " << filename << " for writing" << endl;
+		return false;
+	}
+	out << "PF\n" << width << " " << height << "\n-1.0\n";
+	const size_t numFloats = (size_t)3 * width * height;
+	const unsigned short ONE = 1;
+	if (*(const unsigned char*)&ONE == 1) {
+		out.write((const char*)rgb, numFloats * sizeof(float));
+	} else {
+		for (size_t i = 0; i < numFloats; i++) {
+			unsigned char bytes[sizeof(float)];
+			std::memcpy(bytes, &rgb[i], sizeof(float));
+			std::swap(bytes[0], bytes[3]);
+			std::swap(bytes[1], bytes[2]);
+			out.write((const char*)bytes, sizeof(bytes));
+		}
+	}
+	return (bool)out;
+}
+
+/**
+ * @fn	FrameExporter::FrameExporter(int maxPendingFrames)
+ * @brief	Constructs an exporter. The I/O thread is started by the first save,
+ * 			so exporters can be globals.
+ * @param	maxPendingFrames	How many frames are expected to be copied but not
+ * 								yet written at once; at least 1. Copies for this
+ * 								many are kept for reuse, and a deeper queue draws
+ * 								a warning.
+ */
+
+FrameExporter::FrameExporter(int maxPendingFrames)
+	: maxPendingFrames(std::max(maxPendingFrames, 1)) {
+}
+
+/**
+ * @fn	FrameExporter::~FrameExporter()
+ * @brief	Writes every frame still pending, then stops the I/O thread.
+ */
+
+FrameExporter::~FrameExporter() {
+	flush();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		shuttingDown = true;
+		frameQueued.notify_all();
+	}
+	if (ioThread.joinable()) {
+		ioThread.join();
+	}
+}
+
+/**
+ * @fn	void FrameExporter::save(const FrameBuffer& frameBuffer, const std::string& filename)
+ * @brief	Queues a frame to be written, in the format its extension implies.
+ * @param	frameBuffer	The frame.
+ * @param	filename   	Name of the file to create.
+ */
+
+void FrameExporter::save(const FrameBuffer& frameBuffer, const std::string& filename) {
+	save(frameBuffer, filename, imageFileFormat(filename));
+}
+
+/**
+ * @fn	void FrameExporter::save(const FrameBuffer& frameBuffer, const std::string& filename, IMAGE_FILE_FORMAT format)
+ * @brief	Copies a frame and queues it to be written. The frame buffer may be
+ * 			changed as soon as this returns. Never waits for the disk.
+ * @param	frameBuffer	The frame.
+ * @param	filename   	Name of the file to create.
+ * @param	format	   	The file format.
+ */
+
+void FrameExporter::save(const FrameBuffer& frameBuffer, const std::string& filename, IMAGE_FILE_FORMAT format) {
+	std::unique_ptr<PendingFrame> frame;
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		if (!ioThread.joinable()) {
+			ioThread = std::thread(&FrameExporter::ioLoop, this);
+		}
+		numInFlight++;
+		if (numInFlight > maxPendingFrames && !warnedBacklog) {
+			std::cerr << "Warning: frames are rendered faster than they are written; "
+					  << numInFlight << " are waiting" << endl;
+			warnedBacklog = true;
+		}
+		if (!spares.empty()) {
+			frame = std::move(spares.back());
+			spares.pop_back();
+		}
+	}
+	if (frame == nullptr) {
+		frame.reset(new PendingFrame());
+	}
+
+	// Copy outside the lock, so the I/O thread keeps writing meanwhile.
+	frame->filename = filename;
+	frame->format = format;
+	frame->width = frameBuffer.getWindowWidth();
+	frame->height = frameBuffer.getWindowHeight();
+	if (format == PFM_FILE) {
+		frameBuffer.getColorFloats(frame->floats);
+	} else {
+		frameBuffer.getColorBytes(frame->bytes);
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+	queue.push_back(std::move(frame));
+	frameQueued.notify_one();
+}
+
+/**
+ * @fn	void FrameExporter::flush()
+ * @brief	Waits until every frame queued so far has been written.
+ */
+
+void FrameExporter::flush() {
+	std::unique_lock<std::mutex> guard(lock);
+	frameWritten.wait(guard, [this] { return numInFlight == 0; });
+}
+
+/**
+ * @fn	int FrameExporter::getNumFailed() const
+ * @brief	The number of frames that could not be written.
+ * @return	The number of failed writes.
+ */
+
+int FrameExporter::getNumFailed() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return numFailed;
+}
+
+/**
+ * @fn	void FrameExporter::ioLoop()
+ * @brief	Body of the I/O thread: writes queued frames in order until shutdown.
+ */
+
+void FrameExporter::ioLoop() {
+	std::unique_lock<std::mutex> guard(lock);
+	while (true) {
+		frameQueued.wait(guard, [this] { return !queue.empty() || shuttingDown; });
+		if (queue.empty()) {
+			return;
+		}
+		std::unique_ptr<PendingFrame> frame = std::move(queue.front());
+		queue.pop_front();
+		guard.unlock();
+
+		bool ok = frame->format == PFM_FILE
+					? writePFM(frame->filename, frame->width, frame->height, frame->floats.data())
+					: writePPM(frame->filename, frame->width, frame->height, frame->bytes.data());
+
+		guard.lock();
+		numFailed += ok ? 0 : 1;
+		numInFlight--;
+		if ((int)spares.size() < maxPendingFrames) {
+			spares.push_back(std::move(frame));
+		}
+		frameWritten.notify_all();
+	}
+}
+
+/**
+ * @fn	ImageSequence::ImageSequence(FrameExporter& exporter, const std::string& prefix, IMAGE_FILE_FORMAT format, int firstFrame)
+ * @brief	Constructs an image sequence.
+ * @param	exporter  	Writes the frames.
+ * @param	prefix	  	Path and name up to the frame number, e.g., "frames/sweep_".
+ * @param	format	  	The file format; also picks the extension.
+ * @param	firstFrame	Number of the first frame.
+ */
+
+ImageSequence::ImageSequence(FrameExporter& exporter, const std::string& prefix,
+								IMAGE_FILE_FORMAT format, int firstFrame)
+	: exporter(exporter), prefix(prefix), format(format), nextFrame(firstFrame) {
+}
+
+/**
+ * @fn	void ImageSequence::addFrame(const FrameBuffer& frameBuffer)
+ * @brief	Queues the next frame of the sequence.
+ * @param	frameBuffer	The frame.
+ */
+
+void ImageSequence::addFrame(const FrameBuffer& frameBuffer) {
+	exporter.save(frameBuffer, getFileName(nextFrame++), format);
+}
+
+/**
+ * @fn	void ImageSequence::saveFrame(const FrameBuffer& frameBuffer, int frame)
+ * @brief	Queues a given frame of the sequence. Frames may be saved in any
+ * 			order, and from several threads at once.
+ * @param	frameBuffer	The frame.
+ * @param	frame	   	The frame number.
+ */
+
+void ImageSequence::saveFrame(const FrameBuffer& frameBuffer, int frame) {
+	exporter.save(frameBuffer, getFileName(frame), format);
+}
+
+/**
+ * @fn	std::string ImageSequence::getFileName(int frame) const
+ * @brief	The file a frame of the sequence is written to.
+ * @param	frame	The frame number.
+ * @return	The prefix, the frame number padded to four digits, and the extension.
+ */
+
+std::string ImageSequence::getFileName(int frame) const {
+	char number[16];
+	std::snprintf(number, sizeof(number), "%04d", frame);
+	return prefix + number + (format == PFM_FILE ? ".pfm" : ".ppm");
+}
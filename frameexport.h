@@ -0,0 +1,104 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "defs.h"
+#include "framebuffer.h"
+
+/**
+ * @enum	IMAGE_FILE_FORMAT
+ * @brief	File formats a frame can be exported in.
+ */
+
+enum IMAGE_FILE_FORMAT {
+	PPM_FILE,	//!< binary (P6) PPM, 8 bits per channel, as shown on screen
+	PFM_FILE	//!< portable float map, 32-bit floats, unclamped when accumulating
+};
+
+IMAGE_FILE_FORMAT imageFileFormat(const std::string& filename);
+bool writePPM(const std::string& filename, int width, int height, const GLubyte* rgb);
+bool writePFM(const std::string& filename, int width, int height, const float* rgb);
+
+/**
+ * @class	FrameExporter
+ * @brief	Writes frames to disk on a background I/O thread. save() copies the
+ * 			framebuffer and returns, so rendering the next frame overlaps the write.
+ * 			Copies are recycled: with the default of two frames in flight, one is
+ * 			being written while the next is filled (double buffering). save()
+ * 			never waits for the disk, so render threads may call it: if the
+ * 			disk falls more than maxPendingFrames behind, the queue grows and a
+ * 			warning is printed. Only flush() waits.
+ */
+
+class FrameExporter {
+public:
+	FrameExporter(int maxPendingFrames = 2);
+	~FrameExporter();
+	FrameExporter(const FrameExporter&) = delete;
+	FrameExporter& operator=(const FrameExporter&) = delete;
+
+	void save(const FrameBuffer& frameBuffer, const std::string& filename);
+	void save(const FrameBuffer& frameBuffer, const std::string& filename, IMAGE_FILE_FORMAT format);
+	void flush();
+	int getNumFailed() const;
+protected:
+	/**
+	 * @struct	PendingFrame
+	 * @brief	A copy of one frame, waiting to be written.
+	 */
+
+	struct PendingFrame {
+		std::string filename;
+		IMAGE_FILE_FORMAT format;
+		int width, height;
+		std::vector<GLubyte> bytes;		//!< PPM_FILE: row major RGB
+		std::vector<float> floats;		//!< PFM_FILE: row major RGB
+	};
+
+	void ioLoop();
+
+	int maxPendingFrames;									//!< frames expected in flight; more draw a warning, and no more copies are kept for reuse
+	std::thread ioThread;									//!< started by the first save
+	mutable std::mutex lock;								//!< guards everything below
+	std::condition_variable frameQueued;					//!< signaled when a frame is queued or on shutdown
+	std::condition_variable frameWritten;					//!< signaled when a frame is finished
+	std::deque<std::unique_ptr<PendingFrame>> queue;		//!< frames waiting for the I/O thread
+	std::vector<std::unique_ptr<PendingFrame>> spares;		//!< written frames whose buffers can be reused
+	int numInFlight = 0;									//!< frames queued or being written
+	int numFailed = 0;										//!< writes that failed
+	bool shuttingDown = false;
+	bool warnedBacklog = false;								//!< the queue has outgrown maxPendingFrames
+};
+
+/**
+ * @class	ImageSequence
+ * @brief	Numbered files for the frames of an animation, e.g., frame_0000.ppm,
+ * 			frame_0001.ppm, ..., written through a FrameExporter.
+ */
+
+class ImageSequence {
+public:
+	ImageSequence(FrameExporter& exporter, const std::string& prefix,
+					IMAGE_FILE_FORMAT format = PPM_FILE, int firstFrame = 0);
+	void addFrame(const FrameBuffer& frameBuffer);
+	void saveFrame(const FrameBuffer& frameBuffer, int frame);
+	std::string getFileName(int frame) const;
+	int getNextFrame() const { return nextFrame; }
+protected:
+	FrameExporter& exporter;
+	std::string prefix;			//!< path and name up to the frame number
+	IMAGE_FILE_FORMAT format;
+	int nextFrame;				//!< number of the next frame added
+};
@@ -1,233 +1,273 @@
-/****************************************************
- * 2016-2023 Eric Bachmann and Mike Zmuda
- * All Rights Reserved.
- * NOTICE:
- * Dissemination of this information or reproduction
- * of this material is prohibited unless prior written
- * permission is granted.
- ****************************************************/
-
-#include <ctime>
-#include "defs.h"
-#include "io.h"
-#include "ishape.h"
-#include "framebuffer.h"
-#include "raytracer.h"
-#include "iscene.h"
-#include "light.h"
-#include "image.h"
-#include "camera.h"
-#include "rasterization.h"
-
-Image im1("usflag.ppm");
-Image im2("earth.ppm");
-
-int currLight = 0;
-double angle = 0.5;
-const int MINZ = -10;
-const int MAXZ = 4;
-double z = MINZ;
-double inc = 0.4;
-bool isAnimated = false;
-int numReflections = 0;
-int antiAliasing = 1;
-bool multiViewOn = false;
-double spotDirX = 0;
-double spotDirY = -1;
-double spotDirZ = 0;
-
-dvec3 cameraPos(20, 10, 20);
-dvec3 cameraFocus(0, 0, 0);
-dvec3 cameraUp = Y_AXIS;
-
-double cameraFOV = glm::radians(45.0);
-
-vector<PositionalLightPtr> lights = {
-						new PositionalLight(dvec3(23, 16, 9), white),
-						new SpotLight(dvec3(0, 15, 0),
-										dvec3(spotDirX,spotDirY,spotDirZ),
-										glm::radians(90.0),
-										white)
-};
-
-DirectionalLight* dirLight = new DirectionalLight(dvec3(-1, -1, -0.5), white * 0.25);
-
-PositionalLightPtr posLight = lights[0];
-SpotLightPtr spotLight = (SpotLightPtr)lights[1];
-
-FrameBuffer frameBuffer(WINDOW_WIDTH, WINDOW_HEIGHT);
-RayTracer rayTrace(paleGreen);
-IScene scene;
-
-IPlane* plane = new IPlane(dvec3(0.0, -2.0, 0.0), dvec3(0.0, -1.0, 0.0));
-IPlane* clearPlane = new IPlane(dvec3(0.0, 0.0, 0.0), dvec3(0.0, 0.0, 1.0));
-ISphere* sphere1 = new ISphere(dvec3(0.0, 0.0, 0.0), 4.0);
-ISphere* sphere2 = new ISphere(dvec3(13.0, 2.0, 2.0), 1.0);
-IGeometricSphere* geoSphere = new IGeometricSphere(dvec3(-20.0, 2.0, -8.0), 4.0);
-IEllipsoid* ellipsoid = new IEllipsoid(dvec3(-2.0, 3.0, 7.0), dvec3(1.0, 1.0, 2.5));
-ICylinderY* cylinderY = new ICylinderY(dvec3(15.0, 0.0, -4.0), 1.5, 3.0);
-IClosedCylinderY* closedCylinderY = new IClosedCylinderY(dvec3(7.0, 5.0, -4.0), 2.0, 7.0);
-IDisk* disk = new IDisk(dvec3(3.0, 0.0, 14.0), dvec3(1.0, 0.0, 0.0), 3.0);
-ITriangle* tri = new ITriangle(
-	dvec3(-6, 0, 15),
-    dvec3(-8, 8, 11),
-	dvec3(-10, 0, 6)
-);
-IClosedConeY* cone = new IClosedConeY(dvec3(12, 2, -10), 4.0, 4.0);
-
-void buildScene() {
-	scene.addOpaqueObject(new VisibleIShape(plane, tin));
-    scene.addOpaqueObject(new VisibleIShape(clearPlane, glassDielectric));
-
-
-	scene.addOpaqueObject(new VisibleIShape(sphere1, silver, &im2));
-	scene.addOpaqueObject(new VisibleIShape(sphere2, copper));
-	scene.addOpaqueObject(new VisibleIShape(geoSphere, yellowPlastic));
-	scene.addOpaqueObject(new VisibleIShape(ellipsoid, copper));
-
-	scene.addOpaqueObject(new VisibleIShape(closedCylinderY, gold));
-	scene.addOpaqueObject(new VisibleIShape(cylinderY, red, &im1));
-
-	scene.addOpaqueObject(new VisibleIShape(cone, greenPlastic));
-
-	scene.addOpaqueObject(new VisibleIShape(disk, redPlastic));
-    scene.addOpaqueObject(new VisibleIShape(tri, greenRubber));
-
-
-	scene.addLight(lights[0]);
-	scene.addLight(lights[1]);
-    scene.addLight(dirLight);
-
-	lights[0]->isOn = true;
-	lights[1]->isOn = false;
-}
-
-void render() {
-	int frameStartTime = glutGet(GLUT_ELAPSED_TIME);
-	int width = frameBuffer.getWindowWidth();
-	int height = frameBuffer.getWindowHeight();
-	frameBuffer.clearColorBuffer();
-
-	scene.camera = new PerspectiveCamera(cameraPos, cameraFocus, cameraUp, cameraFOV, width, height);
-	rayTrace.raytraceScene(frameBuffer, numReflections, scene, antiAliasing);
-
-	frameBuffer.showColorBuffer();
-	int frameEndTime = glutGet(GLUT_ELAPSED_TIME); // Get end time
-	double totalTimeSec = (frameEndTime - frameStartTime) / 1000.0;
-	if (isAnimated) {
-		cout << "Transparent plane's z value: " << clearPlane->a.z << endl;
-	}
-	cout << "Render time: " << totalTimeSec << " sec." << endl;
-}
-
-void resize(int width, int height) {
-	frameBuffer.setFrameBufferSize(width, height);
-	glutPostRedisplay();
-}
-void incrementClamp(double& v, double delta, double lo, double hi) {
-	v = glm::clamp(v + delta, lo, hi);
-}
-
-void incrementClamp(int& v, int delta, int lo, int hi) {
-	v = glm::clamp(v + delta, lo, hi);
-}
-
-void timer(int id) {
-	if (isAnimated) {
-		z += inc;
-		if (z <= MINZ) {
-			inc = -inc;
-		}
-		else if (z >= MAXZ) {
-			inc = -inc;
-		}
-	}
-	clearPlane->a = dvec3(0, 0, z);
-	glutTimerFunc(TIME_INTERVAL, timer, 0);
-	glutPostRedisplay();
-}
-
-void keyboard(unsigned char key, int x, int y) {
-	//int W, H;
-	const double INC = 0.5;
-	switch (key) {
-	case 'A':
-	case 'a':	currLight = 0;
-		cout << *lights[0] << endl;
-		break;
-	case 'B':
-	case 'b':	currLight = 1;
-		cout << *lights[1] << endl;
-		break;
-	case 'O':
-	case 'o':	lights[currLight]->isOn = !lights[currLight]->isOn;
-		cout << (lights[currLight]->isOn ? "ON" : "OFF") << endl;
-		break;
-	case 'X':
-	case 'x': lights[currLight]->pos.x += (isupper(key) ? INC : -INC);
-		cout << lights[currLight]->pos << endl;
-		break;
-	case 'Y':
-	case 'y': lights[currLight]->pos.y += (isupper(key) ? INC : -INC);
-		cout << lights[currLight]->pos << endl;
-		break;
-	case 'Z':
-	case 'z': lights[currLight]->pos.z += (isupper(key) ? INC : -INC);
-		cout << lights[currLight]->pos << endl;
-		break;
-	case 'J':
-	case 'j':	spotDirX += (isupper(key) ? INC : -INC);
-		spotLight->setDir(spotDirX, spotDirY, spotDirZ);
-		cout << spotLight->spotDir << endl;
-		break;
-	case 'K':
-	case 'k':	spotDirY += (isupper(key) ? INC : -INC);
-		spotLight->setDir(spotDirX, spotDirY, spotDirZ);
-		cout << spotLight->spotDir << endl;
-		break;
-	case 'L':
-	case 'l':	spotDirZ += (isupper(key) ? INC : -INC);
-		spotLight->setDir(spotDirX, spotDirY, spotDirZ);
-		cout << spotLight->spotDir << endl;
-		break;
-	case 'P':
-	case 'p':	isAnimated = !isAnimated;
-		cout << "Animation: " << (isAnimated ? "on" : "off") << endl;
-		break;
-	case '+':	antiAliasing = 3;
-		cout << "Anti aliasing: " << antiAliasing << endl;
-		break;
-	case '-':	antiAliasing = 1;
-		cout << "Anti aliasing: " << antiAliasing << endl;
-		break;
-	case '0':
-	case '1':
-	case '2':
-	case '3':
-	case '4':	numReflections = key - '0';
-		cout << "Num reflections: " << numReflections << endl;
-		break;
-	case ESCAPE:
-		glutLeaveMainLoop();
-		break;
-	default:
-		cout << (int)key << "unmapped key pressed." << endl;
-	}
-
-	glutPostRedisplay();
-}
-
-int main(int argc, char* argv[]) {
-	graphicsInit(argc, argv, __FILE__);
-
-	glutDisplayFunc(render);
-	glutReshapeFunc(resize);
-	glutKeyboardFunc(keyboard);
-	glutMouseFunc(mouseUtility);
-	glutTimerFunc(TIME_INTERVAL, timer, 0);
-	buildScene();
-
-	glutMainLoop();
-
-	return 0;
+/****************************************************
+ * 2016-2023 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <ctime>
+#include "defs.h"
+#include "io.h"
+#include "ishape.h"
+#include "framebuffer.h"
+#include "raytracer.h"
+#include "iscene.h"
+#include "light.h"
+#include "image.h"
+#include "camera.h"
+#include "rasterization.h"
+#include "frameexport.h"
+
+Image im1("usflag.ppm");
+Image im2("earth.ppm");
+
+int currLight = 0;
+double angle = 0.5;
+const int MINZ = -10;
+const int MAXZ = 4;
+double z = MINZ;
+double inc = 0.4;
+bool isAnimated = false;
+int numReflections = 0;
+int antiAliasing = 1;
+int currentPass = 0;			// next progressive pass; RayTracer::NUM_PASSES ==> frame is complete
+int frameStartTime = 0;
+bool multiViewOn = false;
+double spotDirX = 0;
+double spotDirY = -1;
+double spotDirZ = 0;
+
+dvec3 cameraPos(20, 10, 20);
+dvec3 cameraFocus(0, 0, 0);
+dvec3 cameraUp = Y_AXIS;
+
+double cameraFOV = glm::radians(45.0);
+
+vector<PositionalLightPtr> lights = {
+						new PositionalLight(dvec3(23, 16, 9), white),
+						new SpotLight(dvec3(0, 15, 0),
+										dvec3(spotDirX,spotDirY,spotDirZ),
+										glm::radians(90.0),
+										white)
+};
+
+DirectionalLight* dirLight = new DirectionalLight(dvec3(-1, -1, -0.5), white * 0.25);
+
+PositionalLightPtr posLight = lights[0];
+SpotLightPtr spotLight = (SpotLightPtr)lights[1];
+
+FrameBuffer frameBuffer(WINDOW_WIDTH, WINDOW_HEIGHT);
+RayTracer rayTrace(paleGreen);
+IScene scene;
+FrameExporter exporter;
+ImageSequence* recording = nullptr;		// completed frames are saved while this is set
+
+IPlane* plane = new IPlane(dvec3(0.0, -2.0, 0.0), dvec3(0.0, -1.0, 0.0));
+IPlane* clearPlane = new IPlane(dvec3(0.0, 0.0, 0.0), dvec3(0.0, 0.0, 1.0));
+ISphere* sphere1 = new ISphere(dvec3(0.0, 0.0, 0.0), 4.0);
+ISphere* sphere2 = new ISphere(dvec3(13.0, 2.0, 2.0), 1.0);
+IGeometricSphere* geoSphere = new IGeometricSphere(dvec3(-20.0, 2.0, -8.0), 4.0);
+IEllipsoid* ellipsoid = new IEllipsoid(dvec3(-2.0, 3.0, 7.0), dvec3(1.0, 1.0, 2.5));
+ICylinderY* cylinderY = new ICylinderY(dvec3(15.0, 0.0, -4.0), 1.5, 3.0);
+IClosedCylinderY* closedCylinderY = new IClosedCylinderY(dvec3(7.0, 5.0, -4.0), 2.0, 7.0);
+IDisk* disk = new IDisk(dvec3(3.0, 0.0, 14.0), dvec3(1.0, 0.0, 0.0), 3.0);
+ITriangle* tri = new ITriangle(
+	dvec3(-6, 0, 15),
+    dvec3(-8, 8, 11),
+	dvec3(-10, 0, 6)
+);
+IClosedConeY* cone = new IClosedConeY(dvec3(12, 2, -10), 4.0, 4.0);
+
+void buildScene() {
+	scene.addOpaqueObject(new VisibleIShape(plane, tin));
+    scene.addOpaqueObject(new VisibleIShape(clearPlane, glassDielectric));
+
+
+	scene.addOpaqueObject(new VisibleIShape(sphere1, silver, &im2));
+	scene.addOpaqueObject(new VisibleIShape(sphere2, copper));
+	scene.addOpaqueObject(new VisibleIShape(geoSphere, yellowPlastic));
+	scene.addOpaqueObject(new VisibleIShape(ellipsoid, copper));
+
+	scene.addOpaqueObject(new VisibleIShape(closedCylinderY, gold));
+	scene.addOpaqueObject(new VisibleIShape(cylinderY, red, &im1));
+
+	scene.addOpaqueObject(new VisibleIShape(cone, greenPlastic));
+
+	scene.addOpaqueObject(new VisibleIShape(disk, redPlastic));
+    scene.addOpaqueObject(new VisibleIShape(tri, greenRubber));
+
+
+	scene.addLight(lights[0]);
+	scene.addLight(lights[1]);
+    scene.addLight(dirLight);
+
+	lights[0]->isOn = true;
+	lights[1]->isOn = false;
+}
+
+void restartFrame() {
+	currentPass = 0;
+	glutPostRedisplay();
+}
+
+void render() {
+	if (currentPass >= RayTracer::NUM_PASSES) {
+		frameBuffer.showColorBuffer();
+		return;
+	}
+	if (currentPass == 0) {
+		frameStartTime = glutGet(GLUT_ELAPSED_TIME);
+		int width = frameBuffer.getWindowWidth();
+		int height = frameBuffer.getWindowHeight();
+		scene.camera = new PerspectiveCamera(cameraPos, cameraFocus, cameraUp, cameraFOV, width, height);
+	}
+
+	// One pass per redisplay, so input arriving between passes restarts the frame
+	// instead of waiting for the rest of it.
+	rayTrace.raytracePass(frameBuffer, numReflections, scene, currentPass, antiAliasing);
+	currentPass++;
+
+	int frameEndTime = glutGet(GLUT_ELAPSED_TIME); // Get end time
+	double totalTimeSec = (frameEndTime - frameStartTime) / 1000.0;
+	if (currentPass == 1) {
+		cout << "First pass: " << totalTimeSec << " sec." << endl;
+	}
+	if (currentPass < RayTracer::NUM_PASSES) {
+		glutPostRedisplay();
+		return;
+	}
+	if (isAnimated) {
+		cout << "Transparent plane's z value: " << clearPlane->a.z << endl;
+	}
+	cout << "Render time: " << totalTimeSec << " sec." << endl;
+	if (recording != nullptr) {
+		cout << "Saving " << recording->getFileName(recording->getNextFrame()) << endl;
+		recording->addFrame(frameBuffer);
+	}
+}
+
+void resize(int width, int height) {
+	frameBuffer.setFrameBufferSize(width, height);
+	restartFrame();
+}
+void incrementClamp(double& v, double delta, double lo, double hi) {
+	v = glm::clamp(v + delta, lo, hi);
+}
+
+void incrementClamp(int& v, int delta, int lo, int hi) {
+	v = glm::clamp(v + delta, lo, hi);
+}
+
+void timer(int id) {
+	if (isAnimated) {
+		z += inc;
+		if (z <= MINZ) {
+			inc = -inc;
+		}
+		else if (z >= MAXZ) {
+			inc = -inc;
+		}
+	}
+	clearPlane->a = dvec3(0, 0, z);
+	glutTimerFunc(TIME_INTERVAL, timer, 0);
+	if (isAnimated) {
+		restartFrame();
+	}
+}
+
+void keyboard(unsigned char key, int x, int y) {
+	//int W, H;
+	const double INC = 0.5;
+	switch (key) {
+	case 'A':
+	case 'a':	currLight = 0;
+		cout << *lights[0] << endl;
+		break;
+	case 'B':
+	case 'b':	currLight = 1;
+		cout << *lights[1] << endl;
+		break;
+	case 'O':
+	case 'o':	lights[currLight]->isOn = !lights[currLight]->isOn;
+		cout << (lights[currLight]->isOn ? "ON" : "OFF") << endl;
+		break;
+	case 'X':
+	case 'x': lights[currLight]->pos.x += (isupper(key) ? INC : -INC);
+		cout << lights[currLight]->pos << endl;
+		break;
+	case 'Y':
+	case 'y': lights[currLight]->pos.y += (isupper(key) ? INC : -INC);
+		cout << lights[currLight]->pos << endl;
+		break;
+	case 'Z':
+	case 'z': lights[currLight]->pos.z += (isupper(key) ? INC : -INC);
+		cout << lights[currLight]->pos << endl;
+		break;
+	case 'J':
+	case 'j':	spotDirX += (isupper(key) ? INC : -INC);
+		spotLight->setDir(spotDirX, spotDirY, spotDirZ);
+		cout << spotLight->spotDir << endl;
+		break;
+	case 'K':
+	case 'k':	spotDirY += (isupper(key) ? INC : -INC);
+		spotLight->setDir(spotDirX, spotDirY, spotDirZ);
+		cout << spotLight->spotDir << endl;
+		break;
+	case 'L':
+	case 'l':	spotDirZ += (isupper(key) ? INC : -INC);
+		spotLight->setDir(spotDirX, spotDirY, spotDirZ);
+		cout << spotLight->spotDir << endl;
+		break;
+	case 'P':
+	case 'p':	isAnimated = !isAnimated;
+		cout << "Animation: " << (isAnimated ? "on" : "off") << endl;
+		break;
+	case 'S':
+	case 's':	if (recording == nullptr) {
+					recording = new ImageSequence(exporter, "fullraytrace_");
+					cout << "Recording frames" << endl;
+				} else {
+					delete recording;
+					recording = nullptr;
+					cout << "Recording stopped" << endl;
+				}
+		break;
+	case '+':	antiAliasing = 3;
+		cout << "Anti aliasing: " << antiAliasing << endl;
+		break;
+	case '-':	antiAliasing = 1;
+		cout << "Anti aliasing: " << antiAliasing << endl;
+		break;
+	case '0':
+	case '1':
+	case '2':
+	case '3':
+	case '4':	numReflections = key - '0';
+		cout << "Num reflections: " << numReflections << endl;
+		break;
+	case ESCAPE:
+		glutLeaveMainLoop();
+		break;
+	default:
+		cout << (int)key << "unmapped key pressed." << endl;
+	}
+
+	restartFrame();
+}
+
+int main(int argc, char* argv[]) {
+	graphicsInit(argc, argv, __FILE__);
+
+	glutDisplayFunc(render);
+	glutReshapeFunc(resize);
+	glutKeyboardFunc(keyboard);
+	glutMouseFunc(mouseUtility);
+	glutTimerFunc(TIME_INTERVAL, timer, 0);
+	buildScene();
+
+	glutMainLoop();
+
+	return 0;
 }
\ No newline at end of file
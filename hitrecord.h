@@ -15,6 +15,8 @@
 #include "image.h"
 #include "utilities.h"
 
+struct VisibleIShape;
+
 struct HitRecord {
 	double t;				//!< the t value where the intersection took place.
 	dvec3 interceptPt;		//!< the (x,y,z) value where the intersection took place.
@@ -37,6 +39,7 @@ struct OpaqueHitRecord : HitRecord {
 	Material material;		//!< the Material value of the object.
 	Image* texture;			//!< the texture associated with this object, if any (nullptr when not textured).
 	double u, v;			//!< (u,v) correpsonding to intersection point.
+	const VisibleIShape* object = nullptr;	//!< the object that was hit
 
     /** @brief	Added to support transparency. Indicates whether if the ray
     /** is enter an enclosed object or leaving it. Assumes all rays original
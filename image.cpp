@@ -11,95 +11,592 @@
 #include <fstream>
 #include <utility>
 #include <set>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifndef WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "utilities.h"
+#include "threadpool.h"
 #include "image.h"
 
-static unsigned int getNextChar(std::ifstream& input, string& str) {
-	const int N = 2000;
-	char buf;
-	input.read(&buf, 1);
-	unsigned int result = (unsigned char)buf;
-	return result;
+/**
+ * @class	MappedFile
+ * @brief	Read-only view of a whole file. The file is memory mapped where the
+ * 			platform allows it, and read into memory otherwise.
+ */
+
+class MappedFile {
+public:
+	MappedFile(const string& fileName);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	bool isOpen() const { return start != nullptr; }
+	const unsigned char* begin() const { return start; }
+	const unsigned char* end() const { return start + length; }
+protected:
+	const unsigned char* start = nullptr;
+	size_t length = 0;
+#ifdef WINDOWS
+	std::vector<unsigned char> contents;
+#endif
+};
+
+MappedFile::MappedFile(const string& fileName) {
+#ifndef WINDOWS
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		void* address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address != MAP_FAILED) {
+			madvise(address, (size_t)info.st_size, MADV_SEQUENTIAL);
+			start = (const unsigned char*)address;
+			length = (size_t)info.st_size;
+		}
+	}
+	close(fd);
+#else
+	std::ifstream input(fileName.c_str(), std::ios::binary | std::ios::ate);
+	if (!input) {
+		return;
+	}
+	contents.resize((size_t)input.tellg());
+	input.seekg(0);
+	input.read((char*)contents.data(), contents.size());
+	if (!contents.empty() && input) {
+		start = contents.data();
+		length = contents.size();
+	}
+#endif
 }
 
-static void p3(std::ifstream& input, Image& im) {
-	const int N = 100;
-	char buf[N + 1];
+MappedFile::~MappedFile() {
+#ifndef WINDOWS
+	if (start != nullptr) {
+		munmap((void*)start, length);
+	}
+#endif
+}
+
+static bool isSpace(unsigned char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
 
-	int maxValue;
-	input >> im.W >> im.H >> maxValue;
-	input.getline(buf, N);
+/**
+ * @fn	static bool readHeaderValue(const unsigned char*& p, const unsigned char* end, int& value)
+ * @brief	Reads the next number of a PPM header, skipping whitespace and comments.
+ * @param [in,out]	p	 	Read position; left just past the number.
+ * @param 		  	end  	End of the file.
+ * @param [out]		value	The number.
+ * @return	True iff a number was found.
+ */
 
-	im.pixels = new color[im.W * im.H];
-	color* p = im.pixels;
-	for (int row = 0; row < im.H; row++) {
-		for (int col = 0; col < im.W; col++, p++) {
-			int r, g, b;
-			input >> r >> g >> b;
-			double R = map((double)r, 0.0, (double)maxValue, 0.0, 1.0);
-			double G = map((double)g, 0.0, (double)maxValue, 0.0, 1.0);
-			double B = map((double)b, 0.0, (double)maxValue, 0.0, 1.0);
-			*p = color(R, G, B);
+static bool readHeaderValue(const unsigned char*& p, const unsigned char* end, int& value) {
+	while (p < end && (isSpace(*p) || *p == '#')) {
+		if (*p == '#') {
+			while (p < end && *p != '\n') {
+				p++;
+			}
+		} else {
+			p++;
 		}
 	}
+	if (p == end || *p < '0' || *p > '9') {
+		return false;
+	}
+	value = 0;
+	while (p < end && *p >= '0' && *p <= '9') {
+		value = 10 * value + (*p++ - '0');
+	}
+	return true;
 }
 
-static void p6(std::ifstream& input, Image& im) {
-	const int N = 100;
-	char buf[N + 1];
-
-	int maxValue;
-	input >> im.W >> im.H >> maxValue;
-	input.getline(buf, N);
+/**
+ * @fn	static bool p6(const unsigned char* p, const unsigned char* end, int maxValue, int W, int H, vector<color>& pixels)
+ * @brief	Decodes binary pixel data. Each possible sample value is converted
+ * 			to [0, 1] once, so the loop over the file is just table lookups.
+ * @param 		  	p		 	First byte of pixel data.
+ * @param 		  	end		 	End of the file.
+ * @param 		  	maxValue 	Largest sample value, from the header.
+ * @param 		  	W		 	Width, from the header.
+ * @param 		  	H		 	Height, from the header.
+ * @param [out]		pixels	 	The decoded pixels, row major.
+ * @return	True iff the file held enough data.
+ */
 
-	im.pixels = new color[im.W * im.H];
-	string buffer;
-	color* p = im.pixels;
-	for (int row = 0; row < im.H; row++) {
-		for (int col = 0; col < im.W; col++, p++) {
-			int r, g, b;
-			r = getNextChar(input, buffer);
-			g = getNextChar(input, buffer);
-			b = getNextChar(input, buffer);
-			double R = map((double)r, 0.0, (double)maxValue, 0.0, 1.0);
-			double G = map((double)g, 0.0, (double)maxValue, 0.0, 1.0);
-			double B = map((double)b, 0.0, (double)maxValue, 0.0, 1.0);
-			*p = color(R, G, B);
+static bool p6(const unsigned char* p, const unsigned char* end, int maxValue, int W, int H, vector<color>& pixels) {
+	size_t numSamples = (size_t)3 * W * H;
+	int bytesPerSample = maxValue < 256 ? 1 : 2;
+	if ((size_t)(end - p) < numSamples * bytesPerSample) {
+		return false;
+	}
+	pixels.resize((size_t)W * H);
+	color* out = pixels.data();
+	if (bytesPerSample == 1) {
+		double toUnit[256];
+		for (int i = 0; i < 256; i++) {
+			toUnit[i] = map((double)i, 0.0, (double)maxValue, 0.0, 1.0);
+		}
+		for (size_t i = 0; i < pixels.size(); i++, p += 3) {
+			out[i] = color(toUnit[p[0]], toUnit[p[1]], toUnit[p[2]]);
+		}
+	} else {
+		for (size_t i = 0; i < pixels.size(); i++, p += 6) {
+			out[i] = color(map((double)(p[0] << 8 | p[1]), 0.0, (double)maxValue, 0.0, 1.0),
+						   map((double)(p[2] << 8 | p[3]), 0.0, (double)maxValue, 0.0, 1.0),
+						   map((double)(p[4] << 8 | p[5]), 0.0, (double)maxValue, 0.0, 1.0));
 		}
 	}
+	return true;
 }
 
 /**
- * @fn	Image::Image(char *ppmFileName)
- * @brief	Constructs and image given the name of a PPM file. The file must be
- * 			P3 or P6.
- * @param [in,out]	ppmFileName	Filename of the ppm file.
- */
-
-Image::Image(std::string ppmFileName) : W(0), H(0) {
-	const int N = 100;
-	char buf1[N + 1];
-	char buf2[N + 1];
-	std::ifstream input(ppmFileName.c_str(), std::ios::binary);
-	input.getline(buf1, N);
-	int type = 3;
-	pixels = nullptr;
-
-	while (input.peek() == '#') {
-		input.getline(buf2, N);
-	}
-	string header(buf1);
-	header = header.substr(0, 2);
-	if (header == "P3") {
-		p3(input, *this);
-	} else if (header == "P6") {
-		p6(input, *this);
+ * @fn	static bool p3(const unsigned char* p, const unsigned char* end, int maxValue, int W, int H, vector<color>& pixels)
+ * @brief	Decodes ASCII pixel data. Large files are cut into chunks at whitespace
+ * 			and parsed in parallel: one pass counts each chunk's numbers, so that
+ * 			a second pass knows which sample each chunk starts at.
+ * @param 		  	p		 	First byte of pixel data.
+ * @param 		  	end		 	End of the file.
+ * @param 		  	maxValue 	Largest sample value, from the header.
+ * @param 		  	W		 	Width, from the header.
+ * @param 		  	H		 	Height, from the header.
+ * @param [out]		pixels	 	The decoded pixels, row major.
+ * @return	True iff the file held enough numbers.
+ */
+
+static bool p3(const unsigned char* p, const unsigned char* end, int maxValue, int W, int H, vector<color>& pixels) {
+	const size_t MIN_CHUNK_SIZE = 1 << 20;
+	size_t numSamples = (size_t)3 * W * H;
+	int numChunks = (int)glm::clamp((size_t)(end - p) / MIN_CHUNK_SIZE, (size_t)1,
+									(size_t)(4 * ThreadPool::defaultNumThreads()));
+	vector<const unsigned char*> bounds(numChunks + 1, end);
+	bounds[0] = p;
+	for (int i = 1; i < numChunks; i++) {
+		const unsigned char* q = std::max(p + (end - p) * i / numChunks, bounds[i - 1]);
+		while (q < end && !isSpace(*q)) {
+			q++;
+		}
+		bounds[i] = q;
+	}
+
+	vector<size_t> firstSample(numChunks + 1, 0);
+	auto countNumbers = [&](int chunk) {
+		size_t count = 0;
+		bool inNumber = false;
+		for (const unsigned char* q = bounds[chunk]; q < bounds[chunk + 1]; q++) {
+			bool digit = *q >= '0' && *q <= '9';
+			count += digit && !inNumber;
+			inNumber = digit;
+		}
+		firstSample[chunk + 1] = count;
+	};
+
+	pixels.resize((size_t)W * H);
+	static_assert(sizeof(color) == 3 * sizeof(double), "color must be three packed doubles");
+	double* samples = &pixels[0].x;
+	auto parseNumbers = [&](int chunk) {
+		size_t k = firstSample[chunk];
+		const unsigned char* q = bounds[chunk];
+		const unsigned char* stop = bounds[chunk + 1];
+		while (k < numSamples) {
+			while (q < stop && (*q < '0' || *q > '9')) {
+				q++;
+			}
+			if (q == stop) {
+				break;
+			}
+			int value = 0;
+			while (q < stop && *q >= '0' && *q <= '9') {
+				value = 10 * value + (*q++ - '0');
+			}
+			samples[k++] = map((double)value, 0.0, (double)maxValue, 0.0, 1.0);
+		}
+	};
+
+	if (numChunks == 1) {
+		countNumbers(0);
+		parseNumbers(0);
 	} else {
+		ThreadPool pool;
+		pool.parallelFor(numChunks, countNumbers);
+		for (int i = 0; i < numChunks; i++) {
+			firstSample[i + 1] += firstSample[i];
+		}
+		pool.parallelFor(numChunks, parseNumbers);
+	}
+	return firstSample[numChunks] >= numSamples;
+}
+
+/**
+ * @fn	size_t MipLevel::texelIndex(int x, int y) const
+ * @brief	Where texel (x, y) starts in texels, in units of texels.
+ * @param	x	The column, in [0, W).
+ * @param	y	The row, in [0, H).
+ * @return	The index.
+ */
+
+size_t MipLevel::texelIndex(int x, int y) const {
+	// Spreads the 3 bits of a coordinate within a tile to every other bit.
+	static const int SPREAD[TILE_SIZE] = { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15 };
+	const int TILE_SHIFT = 3;
+	size_t tile = (size_t)(y >> TILE_SHIFT) * tilesPerRow + (x >> TILE_SHIFT);
+	return tile * TILE_SIZE * TILE_SIZE + (SPREAD[x & (TILE_SIZE - 1)] | SPREAD[y & (TILE_SIZE - 1)] << 1);
+}
+
+static size_t bytesPerTexel(TEXEL_FORMAT format) {
+	switch (format) {
+	case DOUBLE_TEXELS:	return sizeof(color);
+	case HALF_TEXELS:	return 4 * sizeof(unsigned short);
+	case RGB8_TEXELS:	return 3;
+	default:			return 4;
+	}
+}
+
+static double linearToSRGB(double x) {
+	return x <= 0.0031308 ? 12.92 * x : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+}
+
+static double sRGBToLinear(double x) {
+	return x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+}
+
+/**
+ * @fn	static unsigned short doubleToHalf(double x)
+ * @brief	Rounds a number to the nearest 16-bit float. Values too large for a
+ * 			half become infinity.
+ * @param	x	The number.
+ * @return	The half's bits.
+ */
+
+static unsigned short doubleToHalf(double x) {
+	unsigned short sign = std::signbit(x) ? 0x8000 : 0;
+	x = std::fabs(x);
+	if (!(x < 65520.0)) {
+		return sign | 0x7c00;
+	}
+	if (x < std::ldexp(1.0, -25)) {
+		return sign;
+	}
+	int exponent;
+	double mantissa = std::frexp(x, &exponent);	// x = mantissa * 2^exponent, mantissa in [0.5, 1)
+	int biased = exponent + 14;
+	if (biased <= 0) {
+		// Subnormal. Rounding up to 0x400 gives the smallest normal, which is correct.
+		return sign | (unsigned short)std::lround(std::ldexp(x, 24));
+	}
+	int fraction = (int)std::lround((2.0 * mantissa - 1.0) * 1024.0);
+	if (fraction == 1024) {
+		fraction = 0;
+		biased++;
+	}
+	return sign | (unsigned short)(biased << 10 | fraction);
+}
+
+/**
+ * @fn	static const float* halfToFloatTable()
+ * @brief	The value of every 16-bit float, so that decoding one is a lookup.
+ * @return	The table, indexed by a half's bits.
+ */
+
+static const float* halfToFloatTable() {
+	static const std::vector<float> table = [] {
+		std::vector<float> values(1 << 16);
+		for (int bits = 0; bits < (1 << 16); bits++) {
+			int exponent = (bits >> 10) & 0x1f;
+			int fraction = bits & 0x3ff;
+			double value;
+			if (exponent == 0) {
+				value = std::ldexp((double)fraction, -24);
+			} else if (exponent == 0x1f) {
+				value = fraction == 0 ? INFINITY : NAN;
+			} else {
+				value = std::ldexp((double)(fraction | 0x400), exponent - 25);
+			}
+			values[bits] = (float)((bits & 0x8000) ? -value : value);
+		}
+		return values;
+	}();
+	return table.data();
+}
+
+/**
+ * @fn	static const double* byteToUnitTable(TEXEL_FORMAT format)
+ * @brief	The color channel value of every byte of an 8-bit format.
+ * @param	format	RGB8_TEXELS, RGBA8_TEXELS or SRGB8_TEXELS.
+ * @return	The table, indexed by byte.
+ */
+
+static const double* byteToUnitTable(TEXEL_FORMAT format) {
+	static const std::vector<double> linear = [] {
+		std::vector<double> values(256);
+		for (int i = 0; i < 256; i++) {
+			values[i] = map((double)i, 0.0, 255.0, 0.0, 1.0);
+		}
+		return values;
+	}();
+	static const std::vector<double> sRGB = [] {
+		std::vector<double> values(256);
+		for (int i = 0; i < 256; i++) {
+			values[i] = sRGBToLinear(i / 255.0);
+		}
+		return values;
+	}();
+	return format == SRGB8_TEXELS ? sRGB.data() : linear.data();
+}
+
+/**
+ * @fn	static MipLevel encodeLevel(const vector<color>& pixels, int W, int H, TEXEL_FORMAT format)
+ * @brief	Converts one level from colors to the given format and tiled layout.
+ *			8-bit channels are clamped to [0, 1].
+ * @param	pixels	The level's texels, row major.
+ * @param	W	  	Width of the level.
+ * @param	H	  	Height of the level.
+ * @param	format	The format to store.
+ * @return	The level.
+ */
+
+static MipLevel encodeLevel(const vector<color>& pixels, int W, int H, TEXEL_FORMAT format) {
+	const int T = MipLevel::TILE_SIZE;
+	MipLevel level;
+	level.W = W;
+	level.H = H;
+	level.tilesPerRow = (W + T - 1) / T;
+	size_t numTexels = (size_t)level.tilesPerRow * ((H + T - 1) / T) * T * T;
+	size_t size = bytesPerTexel(format);
+	level.texels.assign(numTexels * size, 0);
+	for (int y = 0; y < H; y++) {
+		for (int x = 0; x < W; x++) {
+			const color& c = pixels[(size_t)y * W + x];
+			unsigned char* texel = &level.texels[level.texelIndex(x, y) * size];
+			if (format == DOUBLE_TEXELS) {
+				memcpy(texel, &c, sizeof(color));
+			} else if (format == HALF_TEXELS) {
+				unsigned short halves[4] = { doubleToHalf(c.r), doubleToHalf(c.g), doubleToHalf(c.b), 0x3c00 };
+				memcpy(texel, halves, sizeof(halves));
+			} else {
+				for (int i = 0; i < 3; i++) {
+					double value = glm::clamp(c[i], 0.0, 1.0);
+					if (format == SRGB8_TEXELS) {
+						value = linearToSRGB(value);
+					}
+					texel[i] = (unsigned char)std::lround(value * 255.0);
+				}
+				if (size == 4) {
+					texel[3] = 255;
+				}
+			}
+		}
+	}
+	return level;
+}
+
+/**
+ * @fn	static void buildMipmaps(vector<color> pixels, int W, int H, ImageData& im)
+ * @brief	Builds the mip pyramid: each level averages 2x2 blocks of the level
+ * 			above it (the last row or column of an odd sized level is folded into
+ * 			its neighbor), down to a single texel. The averaging is done on colors;
+ * 			each level is then stored in the image's format.
+ * @param 		  	pixels	The full resolution image, row major.
+ * @param 		  	W	  	Its width.
+ * @param 		  	H	  	Its height.
+ * @param [in,out]	im	  	Receives the levels; its format is already set.
+ */
+
+static void buildMipmaps(vector<color> pixels, int W, int H, ImageData& im) {
+	im.levels.clear();
+	im.levels.push_back(encodeLevel(pixels, W, H, im.format));
+	int srcW = W;
+	int srcH = H;
+	while (srcW > 1 || srcH > 1) {
+		int levelW = std::max(srcW / 2, 1);
+		int levelH = std::max(srcH / 2, 1);
+		vector<color> texels(levelW * levelH);
+		for (int y = 0; y < levelH; y++) {
+			int y0 = std::min(2 * y, srcH - 1);
+			int y1 = (y == levelH - 1) ? srcH - 1 : std::min(2 * y + 1, srcH - 1);
+			for (int x = 0; x < levelW; x++) {
+				int x0 = std::min(2 * x, srcW - 1);
+				int x1 = (x == levelW - 1) ? srcW - 1 : std::min(2 * x + 1, srcW - 1);
+				texels[y * levelW + x] = 0.25 * (pixels[y0 * srcW + x0] + pixels[y0 * srcW + x1] +
+												 pixels[y1 * srcW + x0] + pixels[y1 * srcW + x1]);
+			}
+		}
+		im.levels.push_back(encodeLevel(texels, levelW, levelH, im.format));
+		pixels.swap(texels);
+		srcW = levelW;
+		srcH = levelH;
+	}
+}
+
+/**
+ * @fn	std::shared_ptr<const ImageData> Image::load(const std::string& ppmFileName, TEXEL_FORMAT format)
+ * @brief	Reads and decodes a P3 or P6 file, and builds its mip pyramid.
+ * @param	ppmFileName	Filename of the ppm file.
+ * @param	format	   	How to store the texels.
+ * @return	The image, or nullptr if the file could not be read.
+ */
+
+std::shared_ptr<const ImageData> Image::load(const std::string& ppmFileName, TEXEL_FORMAT format) {
+	MappedFile file(ppmFileName);
+	const unsigned char* p = file.begin();
+	const unsigned char* end = file.end();
+	string header = file.isOpen() ? string((const char*)p, std::min<size_t>(2, end - p)) : "";
+
+	auto im = std::make_shared<ImageData>();
+	im->format = format;
+	int maxValue = 0;
+	bool ok = (header == "P3" || header == "P6");
+	if (ok) {
+		p += 2;
+		ok = readHeaderValue(p, end, im->W) && readHeaderValue(p, end, im->H) &&
+			 readHeaderValue(p, end, maxValue) && p < end && isSpace(*p) &&
+			 im->W > 0 && im->H > 0 && maxValue > 0 && maxValue < 65536;
+	}
+	vector<color> pixels;
+	if (ok) {
+		p++;	// the single whitespace character that ends the header
+		ok = header == "P6" ? p6(p, end, maxValue, im->W, im->H, pixels) : p3(p, end, maxValue, im->W, im->H, pixels);
+	}
+	if (!ok) {
 		std::cerr << "Problem with PPM file: " << ppmFileName << "(" << header << ")" << endl;
-		return;
+		return nullptr;
 	}
+	buildMipmaps(std::move(pixels), im->W, im->H, *im);
+	return im;
+}
 
-	input.close();
+/**
+ * @fn	static std::map<string, std::weak_ptr<const ImageData>>& imageCache(std::mutex*& lock)
+ * @brief	The process-wide cache of loaded images, keyed by file name and format.
+ * 			It only holds weak references, so an image's memory is released once
+ * 			the last Image using it is destroyed. Function statics, rather than
+ * 			globals, because images are themselves often globals constructed at
+ * 			static initialization.
+ * @param [out]	lock	The mutex guarding the cache.
+ * @return	The cache.
+ */
+
+static std::map<string, std::weak_ptr<const ImageData>>& imageCache(std::mutex*& lock) {
+	static std::mutex cacheLock;
+	static std::map<string, std::weak_ptr<const ImageData>> cache;
+	lock = &cacheLock;
+	return cache;
+}
+
+/**
+ * @fn	Image::Image(std::string ppmFileName, TEXEL_FORMAT format)
+ * @brief	Constructs and image given the name of a PPM file. The file must be
+ * 			P3 or P6. If an Image of the same file and format already exists, its
+ * 			texels are shared rather than read again.
+ * @param	ppmFileName	Filename of the ppm file.
+ * @param	format	   	How to store the texels. RGB8_TEXELS takes an eighth of the
+ * 						memory of DOUBLE_TEXELS and loses nothing for 8-bit files.
+ */
+
+Image::Image(std::string ppmFileName, TEXEL_FORMAT format) : W(0), H(0) {
+	std::mutex* lock;
+	std::map<string, std::weak_ptr<const ImageData>>& cache = imageCache(lock);
+	string key = ppmFileName + "#" + std::to_string(format);
+	{
+		std::lock_guard<std::mutex> guard(*lock);
+		auto it = cache.find(key);
+		if (it != cache.end()) {
+			data = it->second.lock();
+		}
+	}
+	if (data == nullptr) {
+		data = load(ppmFileName, format);
+		if (data == nullptr) {
+			return;
+		}
+		std::lock_guard<std::mutex> guard(*lock);
+		cache[key] = data;
+	}
+	W = data->W;
+	H = data->H;
+}
+
+/**
+ * @fn	size_t Image::getNumBytes() const
+ * @brief	Memory used by the texels of every level.
+ * @return	The number of bytes.
+ */
+
+size_t Image::getNumBytes() const {
+	size_t total = 0;
+	if (data != nullptr) {
+		for (const MipLevel& level : data->levels) {
+			total += level.texels.size();
+		}
+	}
+	return total;
+}
+
+/**
+ * @fn	static void decodeTexels(const ImageData& im, const MipLevel& mip, const size_t index[], int n, color out[])
+ * @brief	Converts n texels of one level back to colors. Decoding several at
+ * 			once looks up the format and conversion table once for all of them.
+ * @param 	im   	The image.
+ * @param 	mip  	The level the texels are in.
+ * @param 	index	Each texel's index (see MipLevel::texelIndex).
+ * @param 	n	 	The number of texels.
+ * @param [out]	out	The colors.
+ */
+
+static void decodeTexels(const ImageData& im, const MipLevel& mip, const size_t index[], int n, color out[]) {
+	const unsigned char* texels = mip.texels.data();
+	switch (im.format) {
+	case DOUBLE_TEXELS:
+		for (int i = 0; i < n; i++) {
+			memcpy(&out[i], texels + index[i] * sizeof(color), sizeof(color));
+		}
+		break;
+	case HALF_TEXELS: {
+		const float* toFloat = halfToFloatTable();
+		for (int i = 0; i < n; i++) {
+			unsigned short halves[4];
+			memcpy(halves, texels + index[i] * sizeof(halves), sizeof(halves));
+			out[i] = color(toFloat[halves[0]], toFloat[halves[1]], toFloat[halves[2]]);
+		}
+		break;
+	}
+	default: {
+		const double* toUnit = byteToUnitTable(im.format);
+		const size_t size = bytesPerTexel(im.format);
+		for (int i = 0; i < n; i++) {
+			const unsigned char* texel = texels + index[i] * size;
+			out[i] = color(toUnit[texel[0]], toUnit[texel[1]], toUnit[texel[2]]);
+		}
+		break;
+	}
+	}
+}
+
+/**
+ * @fn	color Image::getTexel(int x, int y, int level) const
+ * @brief	Gets one texel, converted back to a color.
+ * @param	x	 	The column, in [0, width of the level).
+ * @param	y	 	The row, in [0, height of the level).
+ * @param	level	Mip level; 0 is the full resolution image.
+ * @return	The texel's color.
+ */
+
+color Image::getTexel(int x, int y, int level) const {
+	const MipLevel& mip = data->levels[level];
+	size_t index = mip.texelIndex(x, y);
+	color c;
+	decodeTexels(*data, mip, &index, 1, &c);
+	return c;
 }
 
 /**
@@ -115,5 +612,99 @@ Image::Image(std::string ppmFileName) : W(0), H(0) {
 color Image::getPixelUV(double u, double v) const {
 	int x = glm::clamp((int)(W * u), 0, W - 1);
 	int y = glm::clamp((int)(H * v), 0, H - 1);
-	return pixels[y * W + x];
+	return getTexel(x, y);
+}
+
+/**
+ * @fn	color Image::getBilinearUV(double u, double v, int level) const
+ * @brief	Bilinear interpolation of the four texels around (u, v) in one level
+ * 			of the pyramid. Coordinates outside [0, 1] are clamped to the edge,
+ * 			as in getPixelUV.
+ * @param	u	 	The u in (u, v).
+ * @param	v	 	The v in (u, v).
+ * @param	level	Mip level; 0 is the full resolution image.
+ * @return	The filtered color.
+ */
+
+color Image::getBilinearUV(double u, double v, int level) const {
+	level = glm::clamp(level, 0, getNumLevels() - 1);
+	const MipLevel& mip = data->levels[level];
+	int w = mip.W;
+	int h = mip.H;
+
+	double x = u * w - 0.5;
+	double y = v * h - 0.5;
+	double fx = glm::floor(x);
+	double fy = glm::floor(y);
+	double s = x - fx;
+	double t = y - fy;
+	int x0 = glm::clamp((int)fx, 0, w - 1);
+	int x1 = glm::clamp((int)fx + 1, 0, w - 1);
+	int y0 = glm::clamp((int)fy, 0, h - 1);
+	int y1 = glm::clamp((int)fy + 1, 0, h - 1);
+	size_t index[4] = { mip.texelIndex(x0, y0), mip.texelIndex(x1, y0),
+						mip.texelIndex(x0, y1), mip.texelIndex(x1, y1) };
+	color texels[4];
+	decodeTexels(*data, mip, index, 4, texels);
+	color bottom = (1.0 - s) * texels[0] + s * texels[1];
+	color top = (1.0 - s) * texels[2] + s * texels[3];
+	return (1.0 - t) * bottom + t * top;
+}
+
+/**
+ * @fn	color Image::getTrilinearUV(double u, double v, double lod) const
+ * @brief	Blends bilinear samples of the two levels around lod.
+ * @param	u  	The u in (u, v).
+ * @param	v  	The v in (u, v).
+ * @param	lod	Level of detail (see levelOfDetail); fractional values blend.
+ * @return	The filtered color.
+ */
+
+color Image::getTrilinearUV(double u, double v, double lod) const {
+	lod = glm::clamp(lod, 0.0, (double)(getNumLevels() - 1));
+	int level = (int)lod;
+	double frac = lod - level;
+	color fine = getBilinearUV(u, v, level);
+	if (frac == 0.0) {
+		return fine;
+	}
+	return (1.0 - frac) * fine + frac * getBilinearUV(u, v, level + 1);
+}
+
+/**
+ * @fn	color Image::sampleUV(double u, double v, double lod, TEXTURE_FILTER filter) const
+ * @brief	Samples the image with the given filter.
+ * @param	u	  	The u in (u, v).
+ * @param	v	  	The v in (u, v).
+ * @param	lod   	Level of detail; ignored by NEAREST_FILTER.
+ * @param	filter	The filter.
+ * @return	The color.
+ */
+
+color Image::sampleUV(double u, double v, double lod, TEXTURE_FILTER filter) const {
+	switch (filter) {
+	case BILINEAR_FILTER:
+		return getBilinearUV(u, v, (int)(glm::max(lod, 0.0) + 0.5));
+	case TRILINEAR_FILTER:
+		return getTrilinearUV(u, v, lod);
+	default:
+		return getPixelUV(u, v);
+	}
+}
+
+/**
+ * @fn	double Image::levelOfDetail(const dvec2& dUVdx, const dvec2& dUVdy) const
+ * @brief	The mip level whose texels match a sample's footprint: log2 of the
+ * 			number of full resolution texels the footprint spans along its longer
+ * 			side. The footprint is given by how (u, v) changes across it in two
+ * 			directions, e.g., one pixel right and one pixel up.
+ * @param	dUVdx	Change in (u, v) across the footprint in one direction.
+ * @param	dUVdy	Change in (u, v) across the footprint in the other.
+ * @return	The level of detail, at least 0.
+ */
+
+double Image::levelOfDetail(const dvec2& dUVdx, const dvec2& dUVdy) const {
+	dvec2 size(W, H);
+	double rho = glm::max(glm::length(dUVdx * size), glm::length(dUVdy * size));
+	return rho > 1.0 ? std::log2(rho) : 0.0;
 }
@@ -9,18 +9,83 @@
 
 #pragma once
 #include <memory>
+#include <vector>
 #include "defs.h"
 #include "colorandmaterials.h"
 
+/**
+ * @enum	TEXTURE_FILTER
+ * @brief	How a texture is sampled.
+ */
+
+enum TEXTURE_FILTER {
+	NEAREST_FILTER,		//!< the closest texel of the full resolution image
+	BILINEAR_FILTER,	//!< bilinear, in the mip level closest to the level of detail
+	TRILINEAR_FILTER	//!< bilinear in the two mip levels around the level of detail, blended
+};
+
+/**
+ * @enum	TEXEL_FORMAT
+ * @brief	How an image stores its texels. Every format but DOUBLE_TEXELS is
+ * 			converted back to a color when sampled.
+ */
+
+enum TEXEL_FORMAT {
+	DOUBLE_TEXELS,	//!< a color per texel, 24 bytes
+	RGB8_TEXELS,	//!< 8 bits per channel, linear steps, 3 bytes. Exact for 8-bit files.
+	RGBA8_TEXELS,	//!< as RGB8_TEXELS, padded with an opaque alpha to 4 aligned bytes
+	SRGB8_TEXELS,	//!< 8 bits per channel on the sRGB curve (finer steps near black), 4 bytes
+	HALF_TEXELS		//!< 16-bit floats, 8 bytes
+};
+
+/**
+ * @struct	MipLevel
+ * @brief	One level of an image's mip pyramid. Texels are stored in TILE_SIZE x
+ * 			TILE_SIZE tiles, row major, and in Morton (Z) order within a tile, so
+ * 			texels that are close in 2D are mostly close in memory. The last row
+ * 			and column of tiles are padded.
+ */
+
+struct MipLevel {
+	static const int TILE_SIZE = 8;		//!< must be a power of 2
+	int W, H;							//!< size, in texels
+	int tilesPerRow;					//!< tiles across the padded level
+	std::vector<unsigned char> texels;	//!< the tiles, in the image's TEXEL_FORMAT
+	size_t texelIndex(int x, int y) const;
+};
+
+/**
+ * @struct	ImageData
+ * @brief	The decoded contents of one PPM file. Every Image constructed from the
+ * 			same file in the same format shares a single, immutable ImageData.
+ */
+
+struct ImageData {
+	int W = 0, H = 0;
+	TEXEL_FORMAT format = RGB8_TEXELS;
+	std::vector<MipLevel> levels;	//!< level 0 is the full resolution image, down to 1x1
+};
+
  /**
   * @struct	Image
-  * @brief	Represents a rectangular RGB image.
+  * @brief	Represents a rectangular RGB image. A mip pyramid, each level half
+  * 		the size of the one before, is built when the image is loaded.
+  * 		Images are cached by file name: constructing a second Image from a
+  * 		file that is still loaded shares its texels instead of reading it again.
   */
 
 struct Image {
 	int W, H;
-	color* pixels;
-	Image(std::string ppmFileName);
-	~Image() { delete[] pixels; }
+	std::shared_ptr<const ImageData> data;	//!< the texels, or nullptr if the file could not be read
+	Image(std::string ppmFileName, TEXEL_FORMAT format = RGB8_TEXELS);
+	int getNumLevels() const { return data == nullptr ? 1 : (int)data->levels.size(); }
+	size_t getNumBytes() const;
+	color getTexel(int x, int y, int level = 0) const;
 	color getPixelUV(double u, double v) const;
+	color getBilinearUV(double u, double v, int level = 0) const;
+	color getTrilinearUV(double u, double v, double lod) const;
+	color sampleUV(double u, double v, double lod, TEXTURE_FILTER filter) const;
+	double levelOfDetail(const dvec2& dUVdx, const dvec2& dUVdy) const;
+protected:
+	static std::shared_ptr<const ImageData> load(const std::string& ppmFileName, TEXEL_FORMAT format);
 };
@@ -38,3 +38,103 @@ void IScene::addTransparentObject(const TransparentIShapePtr obj) {
 void IScene::addLight(const LightSourcePtr light) {
 	lights.push_back(light);
 }
+
+/**
+ * @fn	void IScene::commit(bool singlePrecision, double lightCutoff)
+ * @brief	Updates the acceleration structures. Must be called after objects or
+ * 			lights are added, moved or resized, and before the scene is ray
+ * 			traced. If the objects are the ones last committed, only moved, the
+ * 			hierarchy is refit rather than rebuilt (see CompiledSceneT::refit), so
+ * 			animating a scene costs a linear pass per frame. The light tree is
+ * 			always rebuilt; it is small.
+ * @param	singlePrecision	If true, queries search a single precision copy of
+ * 							the scene (see findClosestIntersection).
+ * @param	lightCutoff	   	Direct light below this is negligible, so attenuated
+ * 							lights have a finite range (see LightTree). 0 ==> exact.
+ */
+
+void IScene::commit(bool singlePrecision, double lightCutoff) {
+	this->singlePrecision = singlePrecision;
+	if (!compiledObjects.refit(opaqueObjs)) {
+		compiledObjects.build(opaqueObjs);
+	}
+	const vector<VisibleIShapePtr> none;
+	const vector<VisibleIShapePtr>& floatObjs = singlePrecision ? opaqueObjs : none;
+	if (!compiledObjectsF.refit(floatObjs)) {
+		compiledObjectsF.build(floatObjs);
+	}
+	lightTree.build(lights, lightCutoff);
+}
+
+/**
+ * @fn	void IScene::findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const
+ * @brief	Finds the closest opaque object hit by a ray, as of the last commit.
+ * 			In single precision, the float search only picks the object; the hit
+ * 			itself is recomputed in double, so hit points (and the EPSILON offsets
+ * 			taken from them) are as accurate as in a double precision trace.
+ * @param 		  	ray	The ray.
+ * @param [in,out]	hit	The closest hit.
+ */
+
+void IScene::findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const {
+	if (!singlePrecision) {
+		compiledObjects.findClosestIntersection(ray, hit);
+		return;
+	}
+	int owner, part;
+	float t;
+	float tMax = hit.t < FLT_MAX ? (float)hit.t : FLT_MAX;
+	if (!compiledObjectsF.findClosestPrimitive(RayF(ray), tMax, owner, part, t)) {
+		return;
+	}
+	VisibleIShapePtr object = compiledObjectsF.getObject(owner);
+	double tExact = object->closestT(ray, part);
+	if (glm::abs(tExact - t) < EPSILON) {
+		object->resolveHit(ray, tExact, part, hit);
+	} else {
+		// The precisions disagree, e.g., float found the surface the ray starts
+		// on. Rare enough to settle with a full double precision search.
+		compiledObjects.findClosestIntersection(ray, hit);
+	}
+}
+
+/**
+ * @fn	void IScene::findClosestIntersections(const RayPacket& packet, OpaqueHitRecord hits[]) const
+ * @brief	Finds the closest opaque object hit by each ray of a packet. The packet
+ * 			only decides which object is closest; the full hit record is then
+ * 			computed one ray at a time.
+ * @param 		  	packet	The rays.
+ * @param [out]		hits  	Per-lane closest hit.
+ */
+
+void IScene::findClosestIntersections(const RayPacket& packet, OpaqueHitRecord hits[]) const {
+	if (singlePrecision) {
+		// The packet kernels are double only; the float scene is searched per ray.
+		for (int i = 0; i < PACKET_SIZE; i++) {
+			if (packet.activeLanes & (1 << i)) {
+				hits[i].t = FLT_MAX;
+				findClosestIntersection(packet.getRay(i), hits[i]);
+			}
+		}
+		return;
+	}
+	VisibleIShapePtr closest[PACKET_SIZE];
+	alignas(32) double tClosest[PACKET_SIZE];
+	compiledObjects.findClosestIntersections(packet, closest, tClosest);
+	for (int i = 0; i < PACKET_SIZE; i++) {
+		if ((packet.activeLanes & (1 << i)) == 0) {
+			continue;
+		}
+		hits[i].t = FLT_MAX;
+		if (closest[i] != nullptr) {
+			int part;
+			double t = closest[i]->closestT(packet.getRay(i), part);
+			if (t != FLT_MAX) {
+				closest[i]->resolveHit(packet.getRay(i), t, part, hits[i]);
+			} else {
+				// The vectorized and scalar tests disagreed (round off); trust the scalar one.
+				compiledObjects.findClosestIntersection(packet.getRay(i), hits[i]);
+			}
+		}
+	}
+}
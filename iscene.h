@@ -16,6 +16,8 @@
 #include "light.h"
 #include "eshape.h"
 #include "ishape.h"
+#include "compiledscene.h"
+#include "lighttree.h"
 
  /**
   * @struct	IScene
@@ -27,7 +29,17 @@ struct IScene {
 	vector<VisibleIShapePtr> opaqueObjs;			//!< All the visible objects in the scene
 	vector<TransparentIShapePtr> transparentObjs;	//!< All the transparent objects in the scene
 	RaytracingCamera* camera;						//!< The one camera in the scene
+	CompiledScene compiledObjects;					//!< opaqueObjs, compiled for ray tracing; see commit()
+	CompiledSceneF compiledObjectsF;				//!< the same in single precision, if singlePrecision
+	bool singlePrecision = false;					//!< true ==> queries search compiledObjectsF
+	LightTree lightTree;							//!< lights, sorted for shading; see commit()
 	void addOpaqueObject(const VisibleIShapePtr obj);
 	void addTransparentObject(const TransparentIShapePtr obj);
 	void addLight(const LightSourcePtr light);
+	void commit(bool singlePrecision = false, double lightCutoff = 0.0);
+	void findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const;
+	void findClosestIntersections(const RayPacket& packet, OpaqueHitRecord hits[]) const;
+	bool occluded(const Ray& ray, double tMax) const {
+		return singlePrecision ? compiledObjectsF.occluded(ray, tMax) : compiledObjects.occluded(ray, tMax);
+	}
 };
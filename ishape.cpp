@@ -9,6 +9,7 @@
 
 #include <vector>
 #include "ishape.h"
+#include "shapekernels.h"
 #include "io.h"
 
  /**
@@ -32,6 +33,93 @@ void IShape::getTexCoords(const dvec3& pt, double& u, double& v) const {
     u = v = 0;
 }
 
+/**
+ * @fn	void IShape::findClosestIntersection(const Ray& ray, HitRecord& hit) const
+ * @brief	Finds the closest intersection in front of the ray, along with its
+ * 			intercept point and normal.
+ * @param 		  	ray	The ray.
+ * @param [in,out]	hit	The hit. t == FLT_MAX if there is none.
+ */
+
+void IShape::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
+    int part;
+    hit.t = closestT(ray, part);
+    if (hit.t < FLT_MAX) {
+        computeHitAttributes(ray, hit.t, part, hit);
+    }
+}
+
+/**
+ * @fn	bool IShape::getBounds(AABB& box) const
+ * @brief	Computes an axis-aligned box enclosing the shape. The default is to
+ * 			report the shape as unbounded.
+ * @param [out]	box	The bounding box, if the shape is bounded.
+ * @return	True iff the shape is bounded.
+ */
+
+bool IShape::getBounds(AABB&) const {
+    return false;
+}
+
+/**
+ * @fn	void IShape::intersectPacket(const RayPacket& packet, double tHit[]) const
+ * @brief	Finds the t value of the closest intersection for each ray of a packet.
+ * 			The default traces the rays one at a time; shapes with a vectorized
+ * 			test override this.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the closest intersection, FLT_MAX if none.
+ */
+
+void IShape::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    for (int i = 0; i < PACKET_SIZE; i++) {
+        tHit[i] = FLT_MAX;
+        if (packet.activeLanes & (1 << i)) {
+            int part;
+            tHit[i] = closestT(packet.getRay(i), part);
+        }
+    }
+}
+
+/**
+ * @fn	bool IShape::occluded(const Ray& ray, double tMax) const
+ * @brief	Determines whether the ray hits the shape closer than tMax. Used for
+ * 			shadow feelers; shapes whose closestT does more work than needed to
+ * 			answer yes/no override this.
+ * @param	ray 	The ray.
+ * @param	tMax	Hits at or beyond this distance are ignored.
+ * @return	True iff the ray hits the shape before tMax.
+ */
+
+bool IShape::occluded(const Ray& ray, double tMax) const {
+    int part;
+    return closestT(ray, part) < tMax;
+}
+
+/**
+ * @fn	template <> int AABBT<double>::intersect(const RayPacket& packet, const double tMax[], double tEnter[]) const
+ * @brief	Slab test of every ray of a packet against the box.
+ * @param 		  	packet	The rays.
+ * @param 		  	tMax  	Per-lane farthest distance of interest.
+ * @param [out]		tEnter	Per-lane t value where the ray enters the box.
+ * @return	Bit i is set iff ray i hits the box within [0, tMax[i]].
+ */
+
+template <>
+int AABBT<double>::intersect(const RayPacket& packet, const double tMax[], double tEnter[]) const {
+    PacketVec3 o = packet.origin();
+    PacketVec3 inv = packet.invDir();
+    PacketDouble tx0 = (PacketDouble(lo.x) - o.x) * inv.x;
+    PacketDouble tx1 = (PacketDouble(hi.x) - o.x) * inv.x;
+    PacketDouble ty0 = (PacketDouble(lo.y) - o.y) * inv.y;
+    PacketDouble ty1 = (PacketDouble(hi.y) - o.y) * inv.y;
+    PacketDouble tz0 = (PacketDouble(lo.z) - o.z) * inv.z;
+    PacketDouble tz1 = (PacketDouble(hi.z) - o.z) * inv.z;
+    PacketDouble tNear = max(max(min(tx0, tx1), min(ty0, ty1)), max(min(tz0, tz1), PacketDouble(0.0)));
+    PacketDouble tFar = min(min(max(tx0, tx1), max(ty0, ty1)), min(max(tz0, tz1), PacketDouble::load(tMax)));
+    tNear.store(tEnter);
+    return (tNear <= tFar).bits() & packet.activeLanes;
+}
+
 /**
  * @fn	dvec3 IShape::movePointOffSurface(const dvec3 &pt, const dvec3 &n)
  * @brief	Compute point that is slightly off surface.
@@ -65,35 +153,54 @@ VisibleIShape::VisibleIShape(IShapePtr shapePtr, const Material& mat, Image* ima
  */
 
 void VisibleIShape::findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const {
-    hit.t = FLT_MAX;
-    this->shape->findClosestIntersection(ray, hit);
+    int part;
+    hit.t = this->shape->closestT(ray, part);
 
     if (hit.t < FLT_MAX) {
-        hit.material = this->material;
+        resolveHit(ray, hit.t, part, hit);
+    }
+}
 
-        hit.texture = this->texture;
+/**
+ * @fn	void VisibleIShape::resolveHit(const Ray& ray, double t, int part, OpaqueHitRecord& hit) const
+ * @brief	Fills in everything about a hit besides t: intercept point, normal,
+ * 			material, texture coordinates and whether the ray is entering or
+ * 			leaving. Only done for the closest hit along a ray.
+ * @param 		  	ray 	The ray.
+ * @param 		  	t   	Where the ray hit this shape (from closestT).
+ * @param 		  	part	The part of the shape that was hit (from closestT).
+ * @param [in,out]	hit 	The hit.
+ */
 
-        if (hit.texture != nullptr) shape->getTexCoords(hit.interceptPt, hit.u, hit.v);
+void VisibleIShape::resolveHit(const Ray& ray, double t, int part, OpaqueHitRecord& hit) const {
+    hit.t = t;
+    hit.object = this;
+    this->shape->computeHitAttributes(ray, t, part, hit);
 
-        if (glm::dot(ray.dir, hit.normal) > 0) {
+    hit.material = this->material;
 
+    hit.texture = this->texture;
 
-            // Reverse the normal vector for correct lighting
-            hit.normal = -hit.normal;
+    if (hit.texture != nullptr) shape->getTexCoords(hit.interceptPt, hit.u, hit.v);
 
+    if (glm::dot(ray.dir, hit.normal) > 0) {
 
-            // Assume the ray is leaving the surface
-            hit.rayStatus = LEAVING;
 
-        }
-        else {
+        // Reverse the normal vector for correct lighting
+        hit.normal = -hit.normal;
 
 
-            // The ray is entering the surface
-            hit.rayStatus = ENTERING;
+        // Assume the ray is leaving the surface
+        hit.rayStatus = LEAVING;
+
+    }
+    else {
+
+
+        // The ray is entering the surface
+        hit.rayStatus = ENTERING;
 
 
-        }
     }
 }
 
@@ -108,14 +215,22 @@ void VisibleIShape::findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit
 void VisibleIShape::findIntersection(const Ray& ray, const vector<VisibleIShapePtr>& surfaces,
     OpaqueHitRecord& closestSoFar) {
 
+    VisibleIShapePtr closest = nullptr;
+    double tClosest = closestSoFar.t;
+    int closestPart = 0;
     for (auto& surface : surfaces) {
-        OpaqueHitRecord thisHit;
-        surface->findClosestIntersection(ray, thisHit);
+        int part;
+        double t = surface->closestT(ray, part);
 
-        if (thisHit.t < closestSoFar.t && thisHit.t != FLT_MAX) {
-            closestSoFar = thisHit;
+        if (t < tClosest && t != FLT_MAX) {
+            closest = surface;
+            tClosest = t;
+            closestPart = part;
         }
     }
+    if (closest != nullptr) {
+        closest->resolveHit(ray, tClosest, closestPart, closestSoFar);
+    }
 }
 
 
@@ -185,30 +300,30 @@ IDisk::IDisk(const dvec3& pos, const dvec3& normal, double rad)
 }
 
 /**
- * @fn	void IDisk::findClosestIntersection(const Ray &ray, HitRecord &hit) const
+ * @fn	double IDisk::closestT(const Ray& ray, int& part) const
  * @brief	Identifies the nearest intersection
- * @param 		  	ray	The ray.
- * @param [in,out]	hit	The hit.
+ * @param 		  	ray 	The ray.
+ * @param [out]		part	Always 0.
+ * @return	The t value of the intersection, or FLT_MAX if there is none.
  */
 
-void IDisk::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    double denom = glm::dot(ray.dir, n);
+double IDisk::closestT(const Ray& ray, int& part) const {
+    part = 0;
+    return diskClosestT(center, n, radius, ray);
+}
 
-    if (glm::abs(denom) > EPSILON) {
-        double t = glm::dot(center - ray.origin, n) / denom;
-        if (t > EPSILON) {
-            dvec3 interceptPt = ray.origin + t * ray.dir;
-            double dist = glm::distance(interceptPt, center);
+/**
+ * @fn	void IDisk::computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const
+ * @brief	Computes the intercept point and normal of a hit found by closestT.
+ * @param 		  	ray 	The ray.
+ * @param 		  	t   	The t value of the hit.
+ * @param 		  	part	Unused.
+ * @param [in,out]	hit 	The hit.
+ */
 
-            if (dist <= radius) {
-                hit.t = t;
-                hit.interceptPt = interceptPt;
-                hit.normal = n;
-                return;
-            }
-        }
-    }
-    hit.t = FLT_MAX;
+void IDisk::computeHitAttributes(const Ray& ray, double t, int, HitRecord& hit) const {
+    hit.interceptPt = ray.origin + t * ray.dir;
+    hit.normal = n;
 }
 
 
@@ -233,6 +348,33 @@ void IDisk::getTexCoords(const dvec3& pt, double& u, double& v) const {
 
 }
 
+/**
+ * @fn	bool IDisk::getBounds(AABB& box) const
+ * @brief	Computes the disk's bounding box.
+ * @param [out]	box	The bounding box.
+ * @return	True.
+ */
+
+bool IDisk::getBounds(AABB& box) const {
+    dvec3 extent(radius * sqrt(glm::max(0.0, 1.0 - n.x * n.x)),
+                 radius * sqrt(glm::max(0.0, 1.0 - n.y * n.y)),
+                 radius * sqrt(glm::max(0.0, 1.0 - n.z * n.z)));
+    extent += dvec3(EPSILON);
+    box = AABB(center - extent, center + extent);
+    return true;
+}
+
+/**
+ * @fn	void IDisk::intersectPacket(const RayPacket& packet, double tHit[]) const
+ * @brief	Vectorized version of findClosestIntersection.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the intersection, FLT_MAX if none.
+ */
+
+void IDisk::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    diskIntersectPacket(center, n, radius, packet, tHit);
+}
+
 /**
  * @fn	ISphere::ISphere(const dvec3 & position, double radius)
  * @brief	Implicit representation of a 3D sphere.
@@ -377,6 +519,22 @@ QuadricParameters QuadricParameters::coneYQParams(double R, double H) {
     return QuadricParameters(R2, -1.0, R2, 0, 0, 0, 0, 0, 0, 0);
 }
 
+/**
+ * @fn	QUADRIC_FORM QuadricParameters::getForm() const
+ * @brief	Determines the sparsest form these parameters fit.
+ * @return	The form.
+ */
+
+QUADRIC_FORM QuadricParameters::getForm() const {
+    if (D != 0 || E != 0 || F != 0 || G != 0 || H != 0 || I != 0) {
+        return GENERAL_QUADRIC;
+    }
+    if (A == B && B == C && A != 0) {
+        return SPHERICAL_QUADRIC;
+    }
+    return AXIS_ALIGNED_QUADRIC;
+}
+
 /**
  * @fn	IPlane::IPlane(const dvec3 &point, const dvec3 &normal)
  * @brief	Constructor
@@ -430,32 +588,30 @@ bool IPlane::onFrontSide(const dvec3& point) const {
 }
 
 /**
- * @fn	void IPlane::findClosestIntersection(const Ray &ray, HitRecord &hit) const
- * @brief	Find the HitRecord for this plane and the passed Ray. The t value of
- *          the HitRecord will be MAX_FLT, if there is no intersection. There are
- *          two ways to produce a non-existant intersection:
- *              1. The ray is parallel to the plane
+ * @fn	double IPlane::closestT(const Ray& ray, int& part) const
+ * @brief	Searches for the closest intersection. There is no intersection when:
+ * 				1. The ray is parallel to the plane
  * 				2. The intersection is behind the ray's origin
- * @param 		  	ray	The ray.
- * @param [in,out]	hit	The hit.
+ * @param 		  	ray 	The ray.
+ * @param [out]		part	Always 0.
+ * @return	The t value of the intersection, or FLT_MAX if there is none.
  */
 
-void IPlane::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    double denom = glm::dot(ray.dir, n);
-
-    if (glm::abs(denom) < EPSILON) {
-        hit.t = FLT_MAX;
-        return;
-    }
-
-    double t = glm::dot(a - ray.origin, n) / denom;
+double IPlane::closestT(const Ray& ray, int& part) const {
+    part = 0;
+    return planeClosestT(a, n, ray);
+}
 
-    if (t < EPSILON) {
-        hit.t = FLT_MAX;
-        return;
-    }
+/**
+ * @fn	void IPlane::computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const
+ * @brief	Computes the intercept point and normal of a hit found by closestT.
+ * @param 		  	ray 	The ray.
+ * @param 		  	t   	The t value of the hit.
+ * @param 		  	part	Unused.
+ * @param [in,out]	hit 	The hit.
+ */
 
-    hit.t = t;
+void IPlane::computeHitAttributes(const Ray& ray, double t, int, HitRecord& hit) const {
     hit.interceptPt = ray.origin + t * ray.dir;
     hit.normal = n;
 
@@ -466,7 +622,16 @@ void IPlane::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
     }
 }
 
+/**
+ * @fn	void IPlane::intersectPacket(const RayPacket& packet, double tHit[]) const
+ * @brief	Vectorized version of findClosestIntersection.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the intersection, FLT_MAX if none.
+ */
 
+void IPlane::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    planeIntersectPacket(a, n, packet, tHit);
+}
 
 /**
  * @fn	void IPlane::findIntersection(const dvec3 &p1, const dvec3 &p2, double &t) const
@@ -557,6 +722,7 @@ bool equalPlanes(const IPlane& p1, const IPlane& p2) {
 
 IQuadricSurface::IQuadricSurface(const QuadricParameters& params, const dvec3& position)
     : IShape(), qParams(params), center(position) {
+    form = qParams.getForm();
     twoA = 2.0 * qParams.A;
     twoB = 2.0 * qParams.B;
     twoC = 2.0 * qParams.C;
@@ -642,11 +808,13 @@ void IQuadricSurface::computeAqBqCq(const Ray& ray, double& Aq, double& Bq, doub
  */
 
 int IQuadricSurface::findIntersections(const Ray& ray, HitRecord hits[2]) const {
-    double Aq, Bq, Cq;
-    computeAqBqCq(ray, Aq, Bq, Cq);
     double roots[2];
-
-    int numRoots = quadratic(Aq, Bq, Cq, roots);
+    int numRoots;
+    switch (form) {
+    case SPHERICAL_QUADRIC: numRoots = quadricRoots<SPHERICAL_QUADRIC>(qParams, center, ray, roots); break;
+    case AXIS_ALIGNED_QUADRIC: numRoots = quadricRoots<AXIS_ALIGNED_QUADRIC>(qParams, center, ray, roots); break;
+    default: numRoots = quadricRoots<GENERAL_QUADRIC>(qParams, center, ray, roots); break;
+    }
     int numIntersections = 0;
 
     for (int i = 0; i < numRoots; i++) {
@@ -664,32 +832,72 @@ int IQuadricSurface::findIntersections(const Ray& ray, HitRecord hits[2]) const
 
 
 /**
- * @fn	void IQuadricSurface::findClosestIntersection(const Ray &ray, HitRecord &hit) const
- * @brief	Searches for the nearest intersection
- * @param 		  	ray	The ray.
- * @param [in,out]	hit	The hit.
+ * @fn	double IQuadricSurface::closestT(const Ray& ray, int& part) const
+ * @brief	Searches for the nearest intersection. Only the roots are computed.
+ * @param 		  	ray 	The ray.
+ * @param [out]		part	Always 0.
+ * @return	The t value of the intersection, or FLT_MAX if there is none.
  */
 
-void IQuadricSurface::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    HitRecord hits[2];
-    hit.t = FLT_MAX;
+double IQuadricSurface::closestT(const Ray& ray, int& part) const {
+    part = 0;
+    switch (form) {
+    case SPHERICAL_QUADRIC: return quadricClosestT<SPHERICAL_QUADRIC>(qParams, center, ray);
+    case AXIS_ALIGNED_QUADRIC: return quadricClosestT<AXIS_ALIGNED_QUADRIC>(qParams, center, ray);
+    default: return quadricClosestT<GENERAL_QUADRIC>(qParams, center, ray);
+    }
+}
 
-    int numIntercepts = findIntersections(ray, hits);
+/**
+ * @fn	void IQuadricSurface::computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const
+ * @brief	Computes the intercept point and normal of a hit found by closestT.
+ * @param 		  	ray 	The ray.
+ * @param 		  	t   	The t value of the hit.
+ * @param 		  	part	Unused.
+ * @param [in,out]	hit 	The hit.
+ */
 
-    if (numIntercepts > 0) {
-        if (numIntercepts == 2 && hits[0].t > hits[1].t) {
-            std::swap(hits[0], hits[1]);
-        }
+void IQuadricSurface::computeHitAttributes(const Ray& ray, double t, int, HitRecord& hit) const {
+    hit.interceptPt = ray.origin + t * ray.dir;
+    hit.normal = normal(hit.interceptPt);
+}
 
-        for (int i = 0; i < numIntercepts; i++) {
-            if (hits[i].t > EPSILON) {
-                hit = hits[i];
-                return;
-            }
-        }
+/**
+ * @fn	bool IQuadricSurface::getBounds(AABB& box) const
+ * @brief	Computes the bounding box of an axis-aligned ellipsoid (which includes
+ * 			spheres). Any other quadric is reported as unbounded.
+ * @param [out]	box	The bounding box, if the quadric is an ellipsoid.
+ * @return	True iff the quadric is an axis-aligned ellipsoid.
+ */
+
+bool IQuadricSurface::getBounds(AABB& box) const {
+    const QuadricParameters& q = qParams;
+    bool isAxisAligned = q.D == 0 && q.E == 0 && q.F == 0 &&
+                         q.G == 0 && q.H == 0 && q.I == 0;
+    if (!isAxisAligned || q.A <= 0 || q.B <= 0 || q.C <= 0 || q.J >= 0) {
+        return false;
     }
+    dvec3 extent(sqrt(-q.J / q.A), sqrt(-q.J / q.B), sqrt(-q.J / q.C));
+    extent += dvec3(EPSILON);
+    box = AABB(center - extent, center + extent);
+    return true;
 }
 
+/**
+ * @fn	void IQuadricSurface::intersectPacket(const RayPacket& packet, double tHit[]) const
+ * @brief	Vectorized version of findClosestIntersection: computes Aq, Bq and Cq for
+ * 			every ray at once and keeps the nearest root in front of each ray.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the closest intersection, FLT_MAX if none.
+ */
+
+void IQuadricSurface::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    switch (form) {
+    case SPHERICAL_QUADRIC: quadricIntersectPacket<SPHERICAL_QUADRIC>(qParams, center, packet, tHit); break;
+    case AXIS_ALIGNED_QUADRIC: quadricIntersectPacket<AXIS_ALIGNED_QUADRIC>(qParams, center, packet, tHit); break;
+    default: quadricIntersectPacket<GENERAL_QUADRIC>(qParams, center, packet, tHit); break;
+    }
+}
 
 /**
  * @fn	dvec3 IQuadricSurface::normal(const dvec3 &P) const
@@ -699,21 +907,11 @@ void IQuadricSurface::findClosestIntersection(const Ray& ray, HitRecord& hit) co
  */
 
 dvec3 IQuadricSurface::normal(const dvec3& P) const {
-    const double& A = qParams.A;
-    const double& B = qParams.B;
-    const double& C = qParams.C;
-    const double& D = qParams.D;
-    const double& E = qParams.E;
-    const double& F = qParams.F;
-    const double& G = qParams.G;
-    const double& H = qParams.H;
-    const double& I = qParams.I;
-    const double& J = qParams.J;
-    dvec3 pt = P - center;
-    dvec3 normal(twoA * pt.x + D * pt.y + E * pt.z + G,
-        twoB * pt.y + D * pt.x + F * pt.z + H,
-        twoC * pt.z + E * pt.x + F * pt.y + I);
-    return glm::normalize(normal);
+    switch (form) {
+    case SPHERICAL_QUADRIC: return quadricNormal<SPHERICAL_QUADRIC>(qParams, center, P);
+    case AXIS_ALIGNED_QUADRIC: return quadricNormal<AXIS_ALIGNED_QUADRIC>(qParams, center, P);
+    default: return quadricNormal<GENERAL_QUADRIC>(qParams, center, P);
+    }
 }
 
 /**
@@ -758,41 +956,45 @@ IConeY::IConeY(const dvec3& pos, double rad, double H)
 }
 
 /**
- * @fn	void ICone::findClosestIntersection(const Ray &ray, HitRecord &hit) const
- * @brief	Searches for the nearest intersection
- * @param 		  	ray	The ray.
- * @param [in,out]	hit	The hit.
+ * @fn	double IConeY::closestT(const Ray& ray, int& part) const
+ * @brief	Searches for the nearest intersection with the part of the cone between
+ * 			its tip and its base.
+ * @param 		  	ray 	The ray.
+ * @param [out]		part	Always 0.
+ * @return	The t value of the intersection, or FLT_MAX if there is none.
  */
 
-void IConeY::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    static HitRecord hits[2];
-    int numHits = IQuadricSurface::findIntersections(ray, hits);
-
-    if (numHits == 0) {
-        hit.t = FLT_MAX;
-        return;
-    }
-
+double IConeY::closestT(const Ray& ray, int& part) const {
+    part = 0;
     double yTip = center.y;
     double yBase = center.y + height;
+    return coneYClosestT(qParams, center, yTip - EPSILON, yBase + EPSILON, ray);
+}
 
-    for (int i = 0; i < numHits; i++) {
-        if (hits[i].t < EPSILON) {
-            hits[i].t = FLT_MAX;
-            continue;
-        }
-        double yVal = hits[i].interceptPt.y;
-        if (yVal < (yTip - EPSILON) || yVal >(yBase + EPSILON)) {
-            hits[i].t = FLT_MAX;
-        }
-    }
+/**
+ * @fn	bool IConeY::getBounds(AABB& box) const
+ * @brief	Computes the cone's bounding box. The tip is at the center and the
+ * 			base is height units above it.
+ * @param [out]	box	The bounding box.
+ * @return	True.
+ */
 
-    if (hits[0].t < hits[1].t) {
-        hit = hits[0];
-    }
-    else {
-        hit = hits[1];
-    }
+bool IConeY::getBounds(AABB& box) const {
+    dvec3 lo(center.x - radius, center.y, center.z - radius);
+    dvec3 hi(center.x + radius, center.y + height, center.z + radius);
+    box = AABB(lo - dvec3(EPSILON), hi + dvec3(EPSILON));
+    return true;
+}
+
+/**
+ * @fn	void IConeY::intersectPacket(const RayPacket& packet, double tHit[]) const
+ * @brief	The cone clips the quadric, so it uses the one-ray-at-a-time test.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the closest intersection, FLT_MAX if none.
+ */
+
+void IConeY::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    IShape::intersectPacket(packet, tHit);
 }
 
 /**
@@ -817,25 +1019,17 @@ ICylinderY::ICylinderY(const dvec3& pos, double rad, double len)
 }
 
 /**
- * @fn	void ICylinderY::findClosestIntersection(const Ray &ray, HitRecord &hit) const
- * @brief	Searches for the nearest intersection
- * @param 		  	ray	The ray.
- * @param [in,out]	hit	The hit.
+ * @fn	double ICylinderY::closestT(const Ray& ray, int& part) const
+ * @brief	Searches for the nearest intersection with the part of the cylinder
+ * 			within length / 2 of its center.
+ * @param 		  	ray 	The ray.
+ * @param [out]		part	Always 0.
+ * @return	The t value of the intersection, or FLT_MAX if there is none.
  */
 
-void ICylinderY::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    HitRecord hits[2];
-    int numHits = IQuadricSurface::findIntersections(ray, hits);
-    hit.t = FLT_MAX;
-
-    if (numHits < 0) return;
-
-    for (int i = 0; i < numHits; i++) {
-        if (hits[i].interceptPt.y < center.y + length / 2 && hits[i].interceptPt.y > center.y - length / 2) {
-            hit = hits[i];
-            return;
-        }
-    }
+double ICylinderY::closestT(const Ray& ray, int& part) const {
+    part = 0;
+    return cylinderYClosestT(qParams, center, center.y - length / 2, center.y + length / 2, ray);
 }
 
 /**
@@ -854,6 +1048,31 @@ void ICylinderY::getTexCoords(const dvec3& pt, double& u, double& v) const {
     v = map(pt.y, bottom, top, 1.0, 0.0);
 }
 
+/**
+ * @fn	bool ICylinderY::getBounds(AABB& box) const
+ * @brief	Computes the cylinder's bounding box.
+ * @param [out]	box	The bounding box.
+ * @return	True.
+ */
+
+bool ICylinderY::getBounds(AABB& box) const {
+    dvec3 extent(radius, length / 2.0, radius);
+    extent += dvec3(EPSILON);
+    box = AABB(center - extent, center + extent);
+    return true;
+}
+
+/**
+ * @fn	void ICylinderY::intersectPacket(const RayPacket& packet, double tHit[]) const
+ * @brief	The cylinder clips the quadric, so it uses the one-ray-at-a-time test.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the closest intersection, FLT_MAX if none.
+ */
+
+void ICylinderY::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    IShape::intersectPacket(packet, tHit);
+}
+
 /**
  * @fn	IEllipsoid::IEllipsoid(const dvec3 &position, const dvec3 &sz)
  * @brief	Constructs an implicit representation of an ellipsoid.
@@ -873,30 +1092,41 @@ IClosedCylinderY::IClosedCylinderY(const dvec3& position, double rad, double H)
 }
 
 
-void IClosedCylinderY::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    OpaqueHitRecord hits[3];
-
-    ICylinderY::findClosestIntersection(ray, hits[0]);
-    top.findClosestIntersection(ray, hits[1]);
-    bottom.findClosestIntersection(ray, hits[2]);
+double IClosedCylinderY::closestT(const Ray& ray, int& part) const {
+    int unused;
+    double hits[3] = { ICylinderY::closestT(ray, unused),
+                       top.closestT(ray, unused),
+                       bottom.closestT(ray, unused) };
 
-    hit.t = FLT_MAX;
+    double t = FLT_MAX;
+    part = 0;
     for (int i = 0; i < 3; i++) {
-        if (hits[i].t < hit.t) hit = hits[i];
+        if (hits[i] < t) {
+            t = hits[i];
+            part = i;
+        }
     }
+    return t;
+}
+
+void IClosedCylinderY::computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const {
+    if (part == 0) ICylinderY::computeHitAttributes(ray, t, 0, hit);
+    else if (part == 1) top.computeHitAttributes(ray, t, 0, hit);
+    else bottom.computeHitAttributes(ray, t, 0, hit);
 }
 
 ITriangle::ITriangle(const dvec3& a, const dvec3& b, const dvec3& c)
     : a(a), b(b), c(c) {
 }
 
-void ITriangle::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    dvec3 n = normalFrom3Points(a, b, c);
-    IPlane plane(a, n);
-    plane.findClosestIntersection(ray, hit);
+double ITriangle::closestT(const Ray& ray, int& part) const {
+    part = 0;
+    return triangleClosestT(TriangleData(a, b, c), ray);
+}
 
-    if (hit.t != FLT_MAX && !inside(hit.interceptPt)) hit.t = FLT_MAX;
-    else hit.normal = n;
+void ITriangle::computeHitAttributes(const Ray& ray, double t, int, HitRecord& hit) const {
+    hit.interceptPt = ray.origin + t * ray.dir;
+    hit.normal = normalFrom3Points(a, b, c);
 }
 
 bool ITriangle::inside(const dvec3& pt) const {
@@ -922,32 +1152,32 @@ bool ITriangle::inside(const dvec3& pt) const {
     return (u >= 0.0 && v >= 0.0 && w >= 0.0 && u <= 1.0 && v <= 1.0 && w <= 1.0);
 }
 
-IGeometricSphere::IGeometricSphere(const dvec3& c, double r)
-    : center(c), radius(r) {
+bool ITriangle::getBounds(AABB& box) const {
+    box = AABB();
+    box.expand(a);
+    box.expand(b);
+    box.expand(c);
+    box.lo -= dvec3(EPSILON);
+    box.hi += dvec3(EPSILON);
+    return true;
 }
 
-void IGeometricSphere::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    dvec3 oc = ray.origin - center;
-    double a = glm::dot(ray.dir, ray.dir);
-    double b = 2.0 * glm::dot(oc, ray.dir);
-    double c = glm::dot(oc, oc) - radius * radius;
-    double discriminant = b * b - 4 * a * c;
-
-    hit.t = FLT_MAX;
+void ITriangle::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    triangleIntersectPacket(TriangleData(a, b, c), packet, tHit);
+}
 
-    if (discriminant >= 0) {
-        double sqrtDiscriminant = sqrt(discriminant);
-        double t1 = (-b - sqrtDiscriminant) / (2 * a);
-        double t2 = (-b + sqrtDiscriminant) / (2 * a);
+IGeometricSphere::IGeometricSphere(const dvec3& c, double r)
+    : center(c), radius(r) {
+}
 
-        double t = (t1 > EPSILON) ? t1 : ((t2 > EPSILON) ? t2 : FLT_MAX);
+double IGeometricSphere::closestT(const Ray& ray, int& part) const {
+    part = 0;
+    return geometricSphereClosestT(center, radius, ray);
+}
 
-        if (t < FLT_MAX) {
-            hit.t = t;
-            hit.interceptPt = ray.origin + t * ray.dir;
-            hit.normal = glm::normalize(hit.interceptPt - center);
-        }
-    }
+void IGeometricSphere::computeHitAttributes(const Ray& ray, double t, int, HitRecord& hit) const {
+    hit.interceptPt = ray.origin + t * ray.dir;
+    hit.normal = glm::normalize(hit.interceptPt - center);
 }
 
 void IGeometricSphere::getTexCoords(const dvec3& pt, double& u, double& v) const {
@@ -959,19 +1189,30 @@ void IGeometricSphere::getTexCoords(const dvec3& pt, double& u, double& v) const
     v = (inclination + PI / 2) / PI;
 }
 
+bool IGeometricSphere::getBounds(AABB& box) const {
+    dvec3 extent(radius + EPSILON);
+    box = AABB(center - extent, center + extent);
+    return true;
+}
+
+void IGeometricSphere::intersectPacket(const RayPacket& packet, double tHit[]) const {
+    geometricSphereIntersectPacket(center, radius, packet, tHit);
+}
+
 IClosedConeY::IClosedConeY(const dvec3& position, double radius, double height)
     : IConeY(position, radius, height),
     base(position + dvec3(0.0, height, 0.0), dvec3(0.0, 1.0, 0.0), radius) {
 }
 
-void IClosedConeY::findClosestIntersection(const Ray& ray, HitRecord& hit) const {
-    OpaqueHitRecord hits[2];
+double IClosedConeY::closestT(const Ray& ray, int& part) const {
+    int unused;
+    double hits[2] = { IConeY::closestT(ray, unused), base.closestT(ray, unused) };
 
-    IConeY::findClosestIntersection(ray, hits[0]);
-    base.findClosestIntersection(ray, hits[1]);
+    part = hits[1] < hits[0] ? 1 : 0;
+    return hits[part];
+}
 
-    hit.t = FLT_MAX;
-    for (int i = 0; i < 2; i++) {
-        if (hits[i].t < hit.t) hit = hits[i];
-    }
+void IClosedConeY::computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const {
+    if (part == 0) IConeY::computeHitAttributes(ray, t, 0, hit);
+    else base.computeHitAttributes(ray, t, 0, hit);
 }
@@ -9,7 +9,9 @@
 
 #pragma once
 #include <vector>
+#include <limits>
 #include "hitrecord.h"
+#include "packet.h"
 
 struct IShape;
 typedef IShape* IShapePtr;
@@ -20,21 +22,113 @@ struct TransparentIShape;
 typedef TransparentIShape* TransparentIShapePtr;
 
 /**
- * @struct	Ray
- * @brief	Represents a ray.
+ * @struct	RayT
+ * @brief	Represents a ray, in double (Ray) or single (RayF) precision.
  */
 
-struct Ray {
-	dvec3 origin;		//!< starting point for this ray
-	dvec3 dir;			//!< direction for this ray, given it's origin
-	Ray(const dvec3& rayOrigin, const dvec3& rayDirection) :
+template <class T>
+struct RayT {
+	glm::tvec3<T> origin;	//!< starting point for this ray
+	glm::tvec3<T> dir;		//!< direction for this ray, given it's origin
+	RayT(const glm::tvec3<T>& rayOrigin, const glm::tvec3<T>& rayDirection) :
 		origin(rayOrigin), dir(glm::normalize(rayDirection)) {
 	}
-	dvec3 getPoint(double t) const {
+	template <class U>
+	explicit RayT(const RayT<U>& ray) :
+		origin(ray.origin), dir(ray.dir) {
+	}
+	glm::tvec3<T> getPoint(T t) const {
 		return origin + t * dir;
 	}
 };
 
+typedef RayT<double> Ray;
+typedef RayT<float> RayF;
+
+/**
+ * @fn	template <class T> inline glm::tvec3<T> inverseDirection(const glm::tvec3<T>& dir)
+ * @brief	Componentwise reciprocal of a direction, with zero components mapped to a
+ * 			huge (but finite) value so the slab test never computes 0 * inf.
+ * @param	dir	The direction.
+ * @return	The reciprocal direction.
+ */
+
+template <class T>
+inline glm::tvec3<T> inverseDirection(const glm::tvec3<T>& dir) {
+	// Small enough to stay finite, and nonzero, in either precision.
+	const T TINY = sizeof(T) < sizeof(double) ? T(1.0e-20) : T(1.0e-30);
+	return glm::tvec3<T>(T(1) / (glm::abs(dir.x) > TINY ? dir.x : (dir.x < 0 ? -TINY : TINY)),
+						T(1) / (glm::abs(dir.y) > TINY ? dir.y : (dir.y < 0 ? -TINY : TINY)),
+						T(1) / (glm::abs(dir.z) > TINY ? dir.z : (dir.z < 0 ? -TINY : TINY)));
+}
+
+/**
+ * @struct	AABBT
+ * @brief	An axis-aligned bounding box, in double (AABB) or single (AABBF)
+ * 			precision. A default-constructed box is empty.
+ */
+
+template <class T>
+struct AABBT {
+	glm::tvec3<T> lo;		//!< minimum corner
+	glm::tvec3<T> hi;		//!< maximum corner
+	AABBT() : lo(std::numeric_limits<T>::max()), hi(-std::numeric_limits<T>::max()) {}
+	AABBT(const glm::tvec3<T>& lo, const glm::tvec3<T>& hi) : lo(lo), hi(hi) {}
+	bool isEmpty() const { return lo.x > hi.x || lo.y > hi.y || lo.z > hi.z; }
+	glm::tvec3<T> centroid() const { return T(0.5) * (lo + hi); }
+	void expand(const glm::tvec3<T>& pt) {
+		lo = glm::min(lo, pt);
+		hi = glm::max(hi, pt);
+	}
+	void expand(const AABBT& box) {
+		lo = glm::min(lo, box.lo);
+		hi = glm::max(hi, box.hi);
+	}
+	bool contains(const glm::tvec3<T>& pt) const {
+		return pt.x >= lo.x && pt.x <= hi.x && pt.y >= lo.y && pt.y <= hi.y && pt.z >= lo.z && pt.z <= hi.z;
+	}
+	T surfaceArea() const {
+		if (isEmpty()) return 0;
+		glm::tvec3<T> d = hi - lo;
+		return T(2) * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+	bool intersect(const glm::tvec3<T>& origin, const glm::tvec3<T>& invDir, T tMax, T& tEnter) const;
+	int intersect(const RayPacket& packet, const double tMax[], double tEnter[]) const;
+};
+
+typedef AABBT<double> AABB;
+typedef AABBT<float> AABBF;
+
+/**
+ * @fn	template <class T> bool AABBT<T>::intersect(const glm::tvec3<T>& origin, const glm::tvec3<T>& invDir, T tMax, T& tEnter) const
+ * @brief	Slab test of a ray against the box.
+ * @param 		  	origin	The ray's origin.
+ * @param 		  	invDir	Componentwise reciprocal of the ray's direction.
+ * @param 		  	tMax  	Hits farther away than this are ignored.
+ * @param [out]		tEnter	The t value where the ray enters the box (0 if it starts inside).
+ * @return	True iff the ray hits the box within [0, tMax].
+ */
+
+template <class T>
+inline bool AABBT<T>::intersect(const glm::tvec3<T>& origin, const glm::tvec3<T>& invDir, T tMax, T& tEnter) const {
+	T tNear = 0;
+	T tFar = tMax;
+	for (int i = 0; i < 3; i++) {
+		T t0 = (lo[i] - origin[i]) * invDir[i];
+		T t1 = (hi[i] - origin[i]) * invDir[i];
+		if (t0 > t1) std::swap(t0, t1);
+		tNear = t0 > tNear ? t0 : tNear;
+		tFar = t1 < tFar ? t1 : tFar;
+		if (tNear > tFar) return false;
+	}
+	tEnter = tNear;
+	return true;
+}
+
+// The packet slab test exists for double boxes only; see ishape.cpp.
+template <>
+int AABBT<double>::intersect(const RayPacket& packet, const double tMax[], double tEnter[]) const;
+
 /**
  * @struct	IShape
  * @brief	Base class for all implicit shapes.
@@ -42,8 +136,13 @@ struct Ray {
 
 struct IShape {
 	IShape();
-	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const = 0;
+	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const;
+	virtual double closestT(const Ray& ray, int& part) const = 0;
+	virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const = 0;
 	virtual void getTexCoords(const dvec3& pt, double& u, double& v) const;
+	virtual bool getBounds(AABB& box) const;
+	virtual void intersectPacket(const RayPacket& packet, double tHit[]) const;
+	virtual bool occluded(const Ray& ray, double tMax) const;
 	static dvec3 movePointOffSurface(const dvec3& pt, const dvec3& n);
 };
 
@@ -58,6 +157,11 @@ struct VisibleIShape {
 	Image* texture;		//!< Texture associated with this shape, if any.
 	VisibleIShape(IShapePtr shapePtr, const Material& mat, Image* image = nullptr);
 	void findClosestIntersection(const Ray& ray, OpaqueHitRecord& hit) const;
+	double closestT(const Ray& ray, int& part) const { return shape->closestT(ray, part); }
+	void resolveHit(const Ray& ray, double t, int part, OpaqueHitRecord& hit) const;
+	bool getBounds(AABB& box) const { return shape->getBounds(box); }
+	void intersectPacket(const RayPacket& packet, double tHit[]) const { shape->intersectPacket(packet, tHit); }
+	bool occluded(const Ray& ray, double tMax) const { return !material.isDielectric && shape->occluded(ray, tMax); }
 	static void findIntersection(const Ray& ray, const vector<VisibleIShapePtr>& surfaces,
 		OpaqueHitRecord& opaqueHitRecord);
 };
@@ -89,7 +193,9 @@ struct IPlane : public IShape {
 	IPlane(const dvec3& point, const dvec3& normal);
 	IPlane(const vector<dvec3>& vertices);
 	IPlane(const dvec3& p1, const dvec3& p2, const dvec3& p3);
-	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const;
+	virtual double closestT(const Ray& ray, int& part) const;
+	virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const;
+	virtual void intersectPacket(const RayPacket& packet, double tHit[]) const;
 	bool onFrontSide(const dvec3& point) const;
 	void findIntersection(const dvec3& p1, const dvec3& p2, double& t) const;
 };
@@ -107,8 +213,11 @@ dvec3 normalFrom3Points(const vector<dvec3>& pts);
 struct IDisk : public IShape {
 	IDisk();
 	IDisk(const dvec3& position, const dvec3& n, double rad);
-	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const;
+	virtual double closestT(const Ray& ray, int& part) const;
+	virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const;
 	virtual void getTexCoords(const dvec3& pt, double& u, double& v) const;
+	virtual bool getBounds(AABB& box) const;
+	virtual void intersectPacket(const RayPacket& packet, double tHit[]) const;
 	dvec3 center;	//!< center point of disk
 	dvec3 n;		//!< normal vector of disk
 	double radius;
@@ -119,6 +228,19 @@ struct IDisk : public IShape {
  * @brief	Represents the 9 parameters that describe a quadric.
  */
 
+/**
+ * @enum	QUADRIC_FORM
+ * @brief	Which coefficients of a quadric can be nonzero. The intersection kernels
+ * 			(shapekernels.h) are templates on the form, so terms known to be zero
+ * 			are compiled out.
+ */
+
+enum QUADRIC_FORM {
+	GENERAL_QUADRIC,		//!< any coefficients
+	AXIS_ALIGNED_QUADRIC,	//!< D through I are 0 (axis-aligned ellipsoids, cylinders, cones)
+	SPHERICAL_QUADRIC		//!< also A == B == C != 0 (spheres)
+};
+
 struct QuadricParameters {
 	double A, B, C, D, E, F, G, H, I, J;
 	QuadricParameters();
@@ -131,12 +253,14 @@ struct QuadricParameters {
 	static QuadricParameters coneYQParams(double R, double H);
 	static QuadricParameters sphereQParams(double R);
 	static QuadricParameters ellipsoidQParams(const dvec3& sz);
+	QUADRIC_FORM getForm() const;
 };
 
 /**
  * @struct	IQuadricSurface
  * @brief	Implicit representation of quadric surface. These shapes can be
- * 			described by the general quadric surface equation
+ * 			described by the general quadric surface equation. Subclasses that
+ * 			clip the surface (i.e., override closestT) must also override intersectPacket.
  */
 
 struct IQuadricSurface : public IShape {
@@ -146,12 +270,18 @@ struct IQuadricSurface : public IShape {
 	IQuadricSurface(const vector<double>& params,
 		const dvec3& position);
 	IQuadricSurface(const dvec3& position);
-	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const;
+	virtual double closestT(const Ray& ray, int& part) const;
+	virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const;
+	virtual bool getBounds(AABB& box) const;
+	virtual void intersectPacket(const RayPacket& packet, double tHit[]) const;
 	int findIntersections(const Ray& ray, HitRecord hits[2]) const;
 	dvec3 normal(const dvec3& pt) const;
 	void computeAqBqCq(const Ray& ray, double& Aq, double& Bq, double& Cq) const;
+	const QuadricParameters& getParameters() const { return qParams; }
+	QUADRIC_FORM getForm() const { return form; }
 protected:
 	QuadricParameters qParams;		//!< The parameters that make up the quadric
+	QUADRIC_FORM form;				//!< Sparsity of qParams; selects the intersection kernel
 	double twoA;					//!< 2*A
 	double twoB;					//!< 2*B
 	double twoC;					//!< 2*C
@@ -194,7 +324,9 @@ struct ICone : public IQuadricSurface {
 
 struct IConeY : public ICone {
 	IConeY(const dvec3& position, double R, double H);
-	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const;
+	virtual double closestT(const Ray& ray, int& part) const;
+	virtual bool getBounds(AABB& box) const;
+	virtual void intersectPacket(const RayPacket& packet, double tHit[]) const;
 };
 
 /**
@@ -205,8 +337,10 @@ struct IConeY : public ICone {
 struct ICylinderY : public ICylinder {
 	ICylinderY();
 	ICylinderY(const dvec3& position, double R, double len);
-	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const;
+	virtual double closestT(const Ray& ray, int& part) const;
 	void getTexCoords(const dvec3& pt, double& u, double& v) const;
+	virtual bool getBounds(AABB& box) const;
+	virtual void intersectPacket(const RayPacket& packet, double tHit[]) const;
 };
 
 /**
@@ -220,7 +354,10 @@ struct IEllipsoid : public IQuadricSurface {
 
 struct IClosedCylinderY : public ICylinderY {
 	IClosedCylinderY(const dvec3& position, double rad, double H);
-	virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const;
+	virtual double closestT(const Ray& ray, int& part) const;
+	virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const;
+	const IDisk& getTop() const { return top; }
+	const IDisk& getBottom() const { return bottom; }
 protected:
 	IDisk top, bottom;
 };
@@ -229,7 +366,10 @@ struct ITriangle : public IShape {
     dvec3 a, b, c;
 
     ITriangle(const dvec3& a, const dvec3& b, const dvec3& c);
-    virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const override;
+    virtual double closestT(const Ray& ray, int& part) const override;
+    virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const override;
+    virtual bool getBounds(AABB& box) const override;
+    virtual void intersectPacket(const RayPacket& packet, double tHit[]) const override;
 	bool inside(const dvec3& pt) const;
 };
 
@@ -238,8 +378,11 @@ struct IGeometricSphere : public IShape {
     double radius;
 
     IGeometricSphere(const dvec3& center, double radius);
-    virtual void findClosestIntersection(const Ray& ray, HitRecord& hit) const override;
+    virtual double closestT(const Ray& ray, int& part) const override;
+    virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const override;
     virtual void getTexCoords(const dvec3& pt, double& u, double& v) const override;
+    virtual bool getBounds(AABB& box) const override;
+    virtual void intersectPacket(const RayPacket& packet, double tHit[]) const override;
 };
 
 class IClosedConeY : public IConeY {
@@ -247,5 +390,6 @@ public:
     IDisk base;
 
     IClosedConeY(const dvec3& position, double radius, double height);
-    void findClosestIntersection(const Ray& ray, HitRecord& hit) const override;
+    double closestT(const Ray& ray, int& part) const override;
+    void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const override;
 };
@@ -8,6 +8,7 @@
  ****************************************************/
 
 #include "light.h"
+#include "iscene.h"
 #include "io.h"
 #include "ishape.h"
 
@@ -139,33 +140,21 @@ dvec3 PositionalLight::actualPosition(const Frame& eyeFrame) const {
 }
 
 /**
-* @fn	bool PositionalLight::pointIsInAShadow(const dvec3& intercept, const dvec3& normal, const vector<VisibleIShapePtr>& objects, const Frame& eyeFrame) const
+* @fn	bool PositionalLight::pointIsInAShadow(const dvec3& intercept, const dvec3& normal, const IScene& scene, const Frame& eyeFrame) const
 * @brief	Determines if an intercept point falls in a shadow.
 * @param	intercept	the position of the intercept.
 * @param	normal		the normal vector at the intercept point
-* @param	objects		the collection of opaque objects in the scene
+* @param	scene		the scene, whose opaque objects cast the shadows
 */
 
 bool PositionalLight::pointIsInAShadow(const dvec3& intercept,
     const dvec3& normal,
-    const vector<VisibleIShapePtr>& objects,
+    const IScene& scene,
     const Frame& eyeFrame) const {
 
     double distanceToLight = glm::distance(intercept, this->pos);
-    dvec3 directionToLight = glm::normalize(this->pos - intercept);
-    Ray shadowFeeler(intercept + EPSILON * normal, directionToLight);
-    OpaqueHitRecord hit;
-
-    for (const auto& obj : objects) {
-        hit.t = FLT_MAX;
-        obj->findClosestIntersection(shadowFeeler, hit);
-
-        if (hit.t < distanceToLight) {
-            if (hit.material.isDielectric) continue;
-            return true;
-        }
-    }
-    return false;
+    Ray shadowFeeler = getShadowFeeler(intercept, normal, eyeFrame);
+    return scene.occluded(shadowFeeler, distanceToLight);
 }
 
 
@@ -180,11 +169,8 @@ bool PositionalLight::pointIsInAShadow(const dvec3& intercept,
 Ray PositionalLight::getShadowFeeler(const dvec3& interceptWorldCoords,
 	const dvec3& normal,
 	const Frame& eyeFrame) const {
-	/* 386 - todo */
-	dvec3 origin(0, 0, 0);
-	dvec3 dir(1, 1, 1);
-	Ray shadowFeeler(origin, dir);
-	return shadowFeeler;
+	dvec3 directionToLight = glm::normalize(this->pos - interceptWorldCoords);
+	return Ray(interceptWorldCoords + EPSILON * normal, directionToLight);
 }
 
 /**
@@ -271,23 +257,11 @@ color DirectionalLight::illuminate(const dvec3& interceptWorldCoords,
 
 bool DirectionalLight::pointIsInAShadow(const dvec3& intercept,
     const dvec3& normal,
-    const vector<VisibleIShapePtr>& objects,
+    const IScene& scene,
     const Frame& eyeFrame) const {
 
-    dvec3 directionToLight = -dir;
-    Ray shadowRay(intercept + EPSILON * normal, directionToLight);
-    OpaqueHitRecord hit;
-
-    for (auto& obj : objects) {
-        hit.t = FLT_MAX;
-        obj->findClosestIntersection(shadowRay, hit);
-
-        if (hit.t < FLT_MAX) {
-            if (hit.material.isDielectric) continue;
-            return true;
-        }
-    }
-    return false;
+    Ray shadowRay = getShadowFeeler(intercept, normal, eyeFrame);
+    return scene.occluded(shadowRay, FLT_MAX);
 }
 
 
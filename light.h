@@ -14,6 +14,8 @@
 #include "hitrecord.h"
 #include "ishape.h"
 
+struct IScene;
+
  /**
   * @struct	LightATParams
   * @brief	A light attenuation parameters.
@@ -71,7 +73,7 @@ struct LightSource {
 		const Frame& eyeFrame) const = 0;
 	virtual bool pointIsInAShadow(const dvec3& intercept,
 		const dvec3& normal,
-		const vector<VisibleIShapePtr>& objects,
+		const IScene& scene,
 		const Frame& eyeFrame) const = 0;
 };
 
@@ -107,7 +109,7 @@ struct PositionalLight : public LightSource {
 		const Frame& eyeFrame) const;
 	virtual bool pointIsInAShadow(const dvec3& intercept, 
 		const dvec3& normal, 
-		const vector<VisibleIShapePtr>& objects,
+		const IScene& scene,
 		const Frame& eyeFrame) const;
 };
 
@@ -127,7 +129,7 @@ struct DirectionalLight : public LightSource {
 
     virtual bool pointIsInAShadow(const dvec3& intercept,
         const dvec3& normal,
-        const vector<VisibleIShapePtr>& objects,
+        const IScene& scene,
         const Frame& eyeFrame) const override;
 
     virtual Ray getShadowFeeler(const dvec3& interceptWorldCoords,
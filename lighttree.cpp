@@ -0,0 +1,143 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <typeinfo>
+#include "lighttree.h"
+
+/**
+ * @fn	double LightTree::range(const PositionalLight& light, double cutoff)
+ * @brief	How far an attenuated light reaches: the distance at which its
+ * 			brightest channel, attenuated and doubled (diffuse plus specular, for
+ * 			materials no brighter than 1), falls to the cutoff.
+ * @param	light 	The light.
+ * @param	cutoff	Light below this is negligible; > 0.
+ * @return	The range; infinite if attenuation never brings the light that low.
+ */
+
+double LightTree::range(const PositionalLight& light, double cutoff) {
+	const LightATParams& at = light.atParams;
+	double brightest = glm::max(light.lightColor.r, glm::max(light.lightColor.g, light.lightColor.b));
+	double K = 2.0 * brightest / cutoff;	// range is where constant + linear d + quadratic d^2 = K
+	if (at.constant >= K) {
+		return 0.0;
+	}
+	if (at.quadratic > 0.0) {
+		return (-at.linear + std::sqrt(at.linear * at.linear - 4.0 * at.quadratic * (at.constant - K))) / (2.0 * at.quadratic);
+	}
+	if (at.linear > 0.0) {
+		return (K - at.constant) / at.linear;
+	}
+	return std::numeric_limits<double>::infinity();
+}
+
+/**
+ * @fn	static AABB spotBounds(const dvec3& pos, const dvec3& dir, double halfAngle, double range)
+ * @brief	Box enclosing the part of a sphere inside a cone whose apex is its
+ * 			center: the apex, the circle where the cone meets the sphere, and the
+ * 			sphere's point on the axis. Cones wider than a hemisphere, and axes
+ * 			that are not unit length (which SpotLight's cone test does not
+ * 			normalize), get the sphere's box.
+ * @param	pos		 	The apex and center.
+ * @param	dir		 	The cone's axis, as the spot light has it.
+ * @param	halfAngle	Angle between the axis and the cone.
+ * @param	range	 	The sphere's radius.
+ * @return	The box.
+ */
+
+static AABB spotBounds(const dvec3& pos, const dvec3& dir, double halfAngle, double range) {
+	if (halfAngle >= PI_2 || std::abs(glm::length(dir) - 1.0) > EPSILON) {
+		return AABB(pos - dvec3(range), pos + dvec3(range));
+	}
+	dvec3 axis = dir;
+	dvec3 rimCenter = pos + range * std::cos(halfAngle) * axis;
+	double rimRadius = range * std::sin(halfAngle);
+	dvec3 rimExtent;
+	for (int i = 0; i < 3; i++) {
+		rimExtent[i] = rimRadius * std::sqrt(std::max(1.0 - axis[i] * axis[i], 0.0));
+	}
+	AABB box(pos, pos);
+	box.expand(rimCenter - rimExtent);
+	box.expand(rimCenter + rimExtent);
+	box.expand(pos + range * axis);
+	return box;
+}
+
+/**
+ * @fn	void LightTree::build(const vector<LightSourcePtr>& lights, double cutoff)
+ * @brief	(Re)builds the tree. Must be called whenever lights move, change or are
+ * 			switched on or off; IScene::commit does.
+ * @param	lights	The lights.
+ * @param	cutoff	Direct light below this is negligible. 0 ==> no light is
+ * 					bounded, and lighting is exact.
+ */
+
+void LightTree::build(const vector<LightSourcePtr>& lights, double cutoff) {
+	globalLights.clear();
+	boundedLights.clear();
+	nodes.clear();
+	positionalAmbient = black;
+
+	vector<LightVolume> bounded;
+	vector<AABB> boxes;
+	for (LightSourcePtr light : lights) {
+		if (!light->isOn) {
+			continue;
+		}
+		LightVolume volume = { light, dvec3(0.0), dvec3(0.0), -2.0,
+								std::numeric_limits<double>::infinity(), false, false };
+		const std::type_info& type = typeid(*light);
+		if (type == typeid(PositionalLight) || type == typeid(SpotLight)) {
+			const PositionalLight* positional = static_cast<const PositionalLight*>(light);
+			volume.pos = positional->pos;
+			if (type == typeid(SpotLight)) {
+				const SpotLight* spot = static_cast<const SpotLight*>(light);
+				volume.spotDir = spot->spotDir;
+				volume.cosCutoff = glm::cos(spot->fov / 2.0);
+			}
+			double reach = std::numeric_limits<double>::infinity();
+			if (cutoff > 0.0 && positional->attenuationIsTurnedOn && positional->isTiedToWorld) {
+				reach = range(*positional, cutoff);
+			}
+			if (reach < std::numeric_limits<double>::infinity()) {
+				volume.isBounded = true;
+				volume.rangeSquared = reach * reach;
+				bounded.push_back(volume);
+				if (type == typeid(SpotLight)) {
+					boxes.push_back(spotBounds(volume.pos, volume.spotDir, static_cast<const SpotLight*>(light)->fov / 2.0, reach));
+				} else {
+					boxes.push_back(AABB(volume.pos - dvec3(reach), volume.pos + dvec3(reach)));
+					bounded.back().ambientIsSummed = true;
+					positionalAmbient += light->lightColor;
+				}
+				continue;
+			}
+		}
+		globalLights.push_back(volume);
+	}
+
+	vector<int> order;
+	BVH::buildHierarchy(boxes, nodes, order);
+	for (int i : order) {
+		boundedLights.push_back(bounded[i]);
+	}
+}
+
+/**
+ * @fn	color LightTree::ambient(const Material& material) const
+ * @brief	The ambient light of the lights whose ambientIsSummed, which they add
+ * 			everywhere, whether or not they reach the point. Callers add only
+ * 			the rest (diffuse and specular) of each such light that forEachLight
+ * 			visits.
+ * @param	material	The material lit.
+ * @return	The ambient color.
+ */
+
+color LightTree::ambient(const Material& material) const {
+	return ambientColor(material.ambient, positionalAmbient);
+}
@@ -0,0 +1,116 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <vector>
+#include "defs.h"
+#include "light.h"
+#include "bvh.h"
+
+/**
+ * @struct	LightVolume
+ * @brief	Where a light can light a point directly: inside its spot cone, if it
+ * 			is a spot light, and within its range, if it has one.
+ */
+
+struct LightVolume {
+	LightSourcePtr light;
+	dvec3 pos;				//!< position (spot and bounded lights only)
+	dvec3 spotDir;			//!< spot direction, as the light has it
+	double cosCutoff;		//!< cosine of half the spot angle; < -1 ==> not a spot light
+	double rangeSquared;	//!< squared range; infinite for lights that are not bounded
+	bool isBounded;			//!< true ==> the light is negligible beyond the range
+	bool ambientIsSummed;	//!< true ==> the light's ambient term is in LightTree::ambient, not visited
+	bool reaches(const dvec3& p) const {
+		if (isBounded && glm::dot(p - pos, p - pos) > rangeSquared) {
+			return false;
+		}
+		return cosCutoff < -1.0 || cosCutoff < glm::dot(spotDir, glm::normalize(p - pos));
+	}
+};
+
+/**
+ * @class	LightTree
+ * @brief	Finds the lights that may light a point directly, so that shading
+ * 			does not cast a shadow feeler toward every light in the scene.
+ *
+ * 			Lights that are off are dropped, and spot lights only count inside
+ * 			their cones; both are exact. With a cutoff > 0, attenuated lights
+ * 			tied to the world are also bounded: a light's range is where its
+ * 			attenuation brings its diffuse plus specular light (for materials
+ * 			no brighter than 1) down to the cutoff. The bounded lights are kept
+ * 			in a BVH over the boxes of their spheres of influence, clipped to
+ * 			their cones. A bounded positional light still adds its ambient term
+ * 			beyond its range, since ambient light does not fade with distance;
+ * 			those terms are summed once (see ambient). A spot light's ambient
+ * 			term only lights its cone, so a bounded spot light adds it where
+ * 			forEachLight visits the light, and nothing beyond its range.
+ *
+ * 			Everything else (directional lights, unattenuated lights, lights
+ * 			tied to the camera, and light types LightTree does not know) is
+ * 			global and visited at every point, in scene order.
+ */
+
+class LightTree {
+public:
+	void build(const vector<LightSourcePtr>& lights, double cutoff);
+	template <class Visit>
+	void forEachLight(const dvec3& p, Visit visit) const;
+	color ambient(const Material& material) const;
+	const vector<LightVolume>& getGlobalLights() const { return globalLights; }
+	const vector<LightVolume>& getBoundedLights() const { return boundedLights; }
+	static double range(const PositionalLight& light, double cutoff);
+protected:
+	vector<LightVolume> globalLights;		//!< visited everywhere, in scene order
+	vector<LightVolume> boundedLights;		//!< in leaf order of the hierarchy
+	vector<BVHNode> nodes;					//!< hierarchy over the bounded lights
+	color positionalAmbient = black;		//!< summed color of the bounded lights whose ambientIsSummed
+};
+
+/**
+ * @fn	template <class Visit> void LightTree::forEachLight(const dvec3& p, Visit visit) const
+ * @brief	Calls visit(volume) for every light that may light p directly: first
+ * 			the global lights that reach p, then the bounded lights whose range
+ * 			(and cone) contains p.
+ * @param	p	 	The point.
+ * @param	visit	Called with the LightVolume of each light.
+ */
+
+template <class Visit>
+void LightTree::forEachLight(const dvec3& p, Visit visit) const {
+	for (const LightVolume& volume : globalLights) {
+		if (volume.reaches(p)) {
+			visit(volume);
+		}
+	}
+	if (nodes.empty()) {
+		return;
+	}
+	const int STACK_SIZE = 64;
+	int stack[STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		int n = stack[--top];
+		const BVHNode& node = nodes[n];
+		if (!node.bounds.contains(p)) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			for (int i = node.start; i < node.start + node.count; i++) {
+				if (boundedLights[i].reaches(p)) {
+					visit(boundedLights[i]);
+				}
+			}
+		} else {
+			stack[top++] = node.secondChild;
+			stack[top++] = n + 1;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include "packet.h"
+#include "ishape.h"
+
+/**
+ * @fn	RayPacket::RayPacket(const Ray* rays, int count)
+ * @brief	Builds a packet from up to PACKET_SIZE rays. Unused lanes repeat the
+ * 			first ray, so that they never produce NaNs, and are marked inactive.
+ * @param	rays 	The rays. Must outlive the packet.
+ * @param	count	Number of rays, between 1 and PACKET_SIZE.
+ */
+
+RayPacket::RayPacket(const Ray* rays, int count)
+	: activeLanes((1 << count) - 1), rays(rays) {
+	for (int i = 0; i < PACKET_SIZE; i++) {
+		const Ray& ray = rays[i < count ? i : 0];
+		dvec3 inv = inverseDirection(ray.dir);
+		ox[i] = ray.origin.x;
+		oy[i] = ray.origin.y;
+		oz[i] = ray.origin.z;
+		dx[i] = ray.dir.x;
+		dy[i] = ray.dir.y;
+		dz[i] = ray.dir.z;
+		ix[i] = inv.x;
+		iy[i] = inv.y;
+		iz[i] = inv.z;
+	}
+}
+
+/**
+ * @fn	const Ray& RayPacket::getRay(int lane) const
+ * @brief	The ray in a lane.
+ * @param	lane	The lane; must be active.
+ * @return	The ray.
+ */
+
+const Ray& RayPacket::getRay(int lane) const {
+	return rays[lane];
+}
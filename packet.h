@@ -0,0 +1,229 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include "defs.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+const int PACKET_SIZE = 4;				//!< rays per packet; one AVX register of doubles.
+const int ALL_LANES = (1 << PACKET_SIZE) - 1;
+
+/**
+ * @struct	PacketDouble
+ * @brief	PACKET_SIZE doubles that are operated on together. Uses AVX when the
+ * 			compiler targets it (e.g., -mavx2), and plain loops otherwise.
+ */
+
+/**
+ * @struct	PacketMask
+ * @brief	Per-lane result of comparing two PacketDoubles.
+ */
+
+#ifdef __AVX__
+
+struct PacketDouble {
+	__m256d v;
+	PacketDouble() {}
+	PacketDouble(double s) : v(_mm256_set1_pd(s)) {}
+	PacketDouble(__m256d m) : v(m) {}
+	static PacketDouble load(const double* p) { return _mm256_load_pd(p); }
+	void store(double* p) const { _mm256_store_pd(p, v); }
+};
+
+struct PacketMask {
+	__m256d m;
+	PacketMask(__m256d x) : m(x) {}
+	int bits() const { return _mm256_movemask_pd(m); }
+};
+
+inline PacketDouble operator+(const PacketDouble& a, const PacketDouble& b) { return _mm256_add_pd(a.v, b.v); }
+inline PacketDouble operator-(const PacketDouble& a, const PacketDouble& b) { return _mm256_sub_pd(a.v, b.v); }
+inline PacketDouble operator*(const PacketDouble& a, const PacketDouble& b) { return _mm256_mul_pd(a.v, b.v); }
+inline PacketDouble operator/(const PacketDouble& a, const PacketDouble& b) { return _mm256_div_pd(a.v, b.v); }
+inline PacketDouble operator-(const PacketDouble& a) { return _mm256_sub_pd(_mm256_setzero_pd(), a.v); }
+inline PacketDouble min(const PacketDouble& a, const PacketDouble& b) { return _mm256_min_pd(a.v, b.v); }
+inline PacketDouble max(const PacketDouble& a, const PacketDouble& b) { return _mm256_max_pd(a.v, b.v); }
+inline PacketDouble sqrt(const PacketDouble& a) { return _mm256_sqrt_pd(a.v); }
+inline PacketDouble abs(const PacketDouble& a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+inline PacketMask operator<(const PacketDouble& a, const PacketDouble& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+inline PacketMask operator<=(const PacketDouble& a, const PacketDouble& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+inline PacketMask operator>(const PacketDouble& a, const PacketDouble& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+inline PacketMask operator>=(const PacketDouble& a, const PacketDouble& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ); }
+inline PacketMask operator==(const PacketDouble& a, const PacketDouble& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ); }
+inline PacketMask operator&(const PacketMask& a, const PacketMask& b) { return _mm256_and_pd(a.m, b.m); }
+inline PacketMask operator|(const PacketMask& a, const PacketMask& b) { return _mm256_or_pd(a.m, b.m); }
+inline PacketDouble select(const PacketMask& mask, const PacketDouble& a, const PacketDouble& b) {
+	return _mm256_blendv_pd(b.v, a.v, mask.m);
+}
+
+#else
+
+struct PacketDouble {
+	double v[PACKET_SIZE];
+	PacketDouble() {}
+	PacketDouble(double s) { for (int i = 0; i < PACKET_SIZE; i++) v[i] = s; }
+	static PacketDouble load(const double* p) {
+		PacketDouble r;
+		for (int i = 0; i < PACKET_SIZE; i++) r.v[i] = p[i];
+		return r;
+	}
+	void store(double* p) const { for (int i = 0; i < PACKET_SIZE; i++) p[i] = v[i]; }
+};
+
+struct PacketMask {
+	bool m[PACKET_SIZE];
+	int bits() const {
+		int b = 0;
+		for (int i = 0; i < PACKET_SIZE; i++) b |= (m[i] ? 1 : 0) << i;
+		return b;
+	}
+};
+
+#define PACKET_BINARY_OP(OP)																\
+inline PacketDouble operator OP(const PacketDouble& a, const PacketDouble& b) {				\
+	PacketDouble r;																			\
+	for (int i = 0; i < PACKET_SIZE; i++) r.v[i] = a.v[i] OP b.v[i];						\
+	return r;																				\
+}
+#define PACKET_COMPARE_OP(OP)																\
+inline PacketMask operator OP(const PacketDouble& a, const PacketDouble& b) {				\
+	PacketMask r;																			\
+	for (int i = 0; i < PACKET_SIZE; i++) r.m[i] = a.v[i] OP b.v[i];						\
+	return r;																				\
+}
+PACKET_BINARY_OP(+)
+PACKET_BINARY_OP(-)
+PACKET_BINARY_OP(*)
+PACKET_BINARY_OP(/)
+PACKET_COMPARE_OP(<)
+PACKET_COMPARE_OP(<=)
+PACKET_COMPARE_OP(>)
+PACKET_COMPARE_OP(>=)
+PACKET_COMPARE_OP(==)
+#undef PACKET_BINARY_OP
+#undef PACKET_COMPARE_OP
+
+inline PacketDouble operator-(const PacketDouble& a) { return PacketDouble(0.0) - a; }
+inline PacketDouble min(const PacketDouble& a, const PacketDouble& b) {
+	PacketDouble r;
+	for (int i = 0; i < PACKET_SIZE; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+	return r;
+}
+inline PacketDouble max(const PacketDouble& a, const PacketDouble& b) {
+	PacketDouble r;
+	for (int i = 0; i < PACKET_SIZE; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+	return r;
+}
+inline PacketDouble sqrt(const PacketDouble& a) {
+	PacketDouble r;
+	for (int i = 0; i < PACKET_SIZE; i++) r.v[i] = std::sqrt(a.v[i]);
+	return r;
+}
+inline PacketDouble abs(const PacketDouble& a) {
+	PacketDouble r;
+	for (int i = 0; i < PACKET_SIZE; i++) r.v[i] = std::fabs(a.v[i]);
+	return r;
+}
+inline PacketMask operator&(const PacketMask& a, const PacketMask& b) {
+	PacketMask r;
+	for (int i = 0; i < PACKET_SIZE; i++) r.m[i] = a.m[i] && b.m[i];
+	return r;
+}
+inline PacketMask operator|(const PacketMask& a, const PacketMask& b) {
+	PacketMask r;
+	for (int i = 0; i < PACKET_SIZE; i++) r.m[i] = a.m[i] || b.m[i];
+	return r;
+}
+inline PacketDouble select(const PacketMask& mask, const PacketDouble& a, const PacketDouble& b) {
+	PacketDouble r;
+	for (int i = 0; i < PACKET_SIZE; i++) r.v[i] = mask.m[i] ? a.v[i] : b.v[i];
+	return r;
+}
+
+#endif
+
+/**
+ * @fn	inline PacketMask quadratic(const PacketDouble& A, const PacketDouble& B, const PacketDouble& C, PacketDouble& r0, PacketDouble& r1)
+ * @brief	Solves PACKET_SIZE quadratic equations at once, using the same
+ * 			cancellation-free formula as quadratic() in utilities.cpp.
+ * @param 		  	A 	The A coefficients.
+ * @param 		  	B 	The B coefficients.
+ * @param 		  	C 	The C coefficients.
+ * @param [out]		r0	The smaller root of each lane (garbage in lanes without roots).
+ * @param [out]		r1	The larger root of each lane; equals r0 for a double root.
+ * @return	The lanes that have real roots.
+ */
+
+inline PacketMask quadratic(const PacketDouble& A, const PacketDouble& B, const PacketDouble& C,
+							PacketDouble& r0, PacketDouble& r1) {
+	PacketDouble zero(0.0);
+	PacketDouble discriminant = B * B - PacketDouble(4.0) * A * C;
+	PacketDouble root = sqrt(max(discriminant, zero));
+	PacketDouble q = PacketDouble(-0.5) * (B + select(B < zero, -root, root));
+	PacketDouble x0 = q / A;
+	PacketDouble x1 = select(q == zero, x0, C / q);
+	r0 = min(x0, x1);
+	r1 = max(x0, x1);
+	return (discriminant >= zero) & ((A < zero) | (A > zero));
+}
+
+/**
+ * @struct	PacketVec3
+ * @brief	PACKET_SIZE 3D vectors, stored as one PacketDouble per coordinate.
+ */
+
+struct PacketVec3 {
+	PacketDouble x, y, z;
+	PacketVec3() {}
+	PacketVec3(const PacketDouble& x, const PacketDouble& y, const PacketDouble& z) : x(x), y(y), z(z) {}
+	PacketVec3(const dvec3& v) : x(v.x), y(v.y), z(v.z) {}
+};
+
+inline PacketVec3 operator-(const PacketVec3& a, const PacketVec3& b) { return PacketVec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline PacketVec3 operator+(const PacketVec3& a, const PacketVec3& b) { return PacketVec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline PacketVec3 operator*(const PacketDouble& s, const PacketVec3& a) { return PacketVec3(s * a.x, s * a.y, s * a.z); }
+inline PacketDouble dot(const PacketVec3& a, const PacketVec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+template <class T> struct RayT;
+typedef RayT<double> Ray;
+
+/**
+ * @struct	RayPacket
+ * @brief	A group of up to PACKET_SIZE rays in structure-of-arrays layout. Lanes
+ * 			that are not in use are left out of activeLanes.
+ */
+
+struct RayPacket {
+	alignas(32) double ox[PACKET_SIZE];		//!< origins
+	alignas(32) double oy[PACKET_SIZE];
+	alignas(32) double oz[PACKET_SIZE];
+	alignas(32) double dx[PACKET_SIZE];		//!< unit directions
+	alignas(32) double dy[PACKET_SIZE];
+	alignas(32) double dz[PACKET_SIZE];
+	alignas(32) double ix[PACKET_SIZE];		//!< reciprocal directions, for box tests
+	alignas(32) double iy[PACKET_SIZE];
+	alignas(32) double iz[PACKET_SIZE];
+	int activeLanes;						//!< bit i set ==> lane i holds a ray
+	const Ray* rays;						//!< the rays this packet was built from
+
+	RayPacket(const Ray* rays, int count);
+	const Ray& getRay(int lane) const;
+	PacketVec3 origin() const {
+		return PacketVec3(PacketDouble::load(ox), PacketDouble::load(oy), PacketDouble::load(oz));
+	}
+	PacketVec3 dir() const {
+		return PacketVec3(PacketDouble::load(dx), PacketDouble::load(dy), PacketDouble::load(dz));
+	}
+	PacketVec3 invDir() const {
+		return PacketVec3(PacketDouble::load(ix), PacketDouble::load(iy), PacketDouble::load(iz));
+	}
+};
@@ -12,13 +12,17 @@
 #include "defs.h"
 #include "fragmentops.h"
 #include "vertexdata.h"
+#include "threadpool.h"
+
+const int RASTER_TILE_SIZE = 64;		//!< width/height of the tiles drawManyFilledTriangles bins triangles into
+const int MIN_BINNED_TRIANGLES = 64;	//!< fewer triangles are drawn serially; binning would not pay
 
 void drawAxisOnWindow(FrameBuffer& frameBuffer);
 void drawWirePolygon(FrameBuffer& frameBuffer, const vector<dvec3>& pts, const color& rgb);
 void drawLine(FrameBuffer& frameBuffer, int x1, int y1, int x2, int y2, const color& C);
 void drawLine(FrameBuffer& frameBuffer, const dvec2& pt1, const dvec2& pt2, const color& C);
 void drawLine(FrameBuffer& frameBuffer, const dvec3& eyePos,
-	vector<LightSourcePtr>& lights,
+	const vector<LightSourcePtr>& lights,
 	const VertexData& v0, const VertexData& v1,
 	const Frame& eyeFrame);
 void drawManyLines(FrameBuffer& frameBuffer, const dvec3& eyePos,
@@ -29,15 +33,19 @@ void drawWireFrameTriangle(FrameBuffer& frameBuffer, const dvec3& eyePos,
 	const VertexData& v0, const VertexData& v1, const VertexData& v2,
 	const Frame& eyeFrame);
 void drawFilledTriangle(FrameBuffer& frameBuffer, const dvec3& eyePos,
-	vector<LightSourcePtr>& lights, const VertexData& v0,
+	const vector<LightSourcePtr>& lights, const VertexData& v0,
 	const VertexData& v1, const VertexData& v2,
 	const Frame& eyeFrame);
+void drawFilledTriangle(FrameBuffer& frameBuffer, const dvec3& eyePos,
+	const vector<LightSourcePtr>& lights, const VertexData& v0,
+	const VertexData& v1, const VertexData& v2,
+	const Frame& eyeFrame, int left, int bottom, int right, int top);
 void drawManyWireFrameTriangles(FrameBuffer& frameBuffer, const dvec3& eyePos,
 	const vector<LightSourcePtr>& lights,
 	const vector<VertexData>& vertices,
 	const Frame& eyeFrame);
 void drawManyFilledTriangles(FrameBuffer& frameBuffer, const dvec3& eyePos,
 	const vector<LightSourcePtr>& lights, const vector<VertexData>& vertices,
-	const Frame& eyeFrame);
+	const Frame& eyeFrame, ThreadPool* pool = nullptr);
 void drawArc(FrameBuffer& fb, const dvec2& center, double R,
 	double startRads, double lengthInRads, const color& rgb);
\ No newline at end of file
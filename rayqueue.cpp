@@ -0,0 +1,138 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include "rayqueue.h"
+
+/**
+ * @fn	void RayQueue::add(const dvec3& origin, const dvec3& dir, const color& w, int p, int l, double c)
+ * @brief	Appends a ray to the queue.
+ * @param	origin	The ray's origin.
+ * @param	dir   	The ray's unit direction.
+ * @param	w	  	The weight its color is scaled by.
+ * @param	p	  	The pixel it contributes to.
+ * @param	l	  	Its recursion level.
+ * @param	c	  	Width of its ray cone at the origin.
+ */
+
+void RayQueue::add(const dvec3& origin, const dvec3& dir, const color& w, int p, int l, double c) {
+	ox.push_back(origin.x);
+	oy.push_back(origin.y);
+	oz.push_back(origin.z);
+	dx.push_back(dir.x);
+	dy.push_back(dir.y);
+	dz.push_back(dir.z);
+	wr.push_back(w.r);
+	wg.push_back(w.g);
+	wb.push_back(w.b);
+	pixel.push_back(p);
+	level.push_back(l);
+	cone.push_back(c);
+}
+
+/**
+ * @fn	void RayQueue::clear()
+ * @brief	Empties the queue, keeping the arrays' storage for the next wave.
+ */
+
+void RayQueue::clear() {
+	for (vector<double>* v : { &ox, &oy, &oz, &dx, &dy, &dz, &wr, &wg, &wb, &cone }) {
+		v->clear();
+	}
+	pixel.clear();
+	level.clear();
+}
+
+/**
+ * @fn	static int spreadBits(int x)
+ * @brief	Inserts two zero bits between each of the low 4 bits of x.
+ * @param	x	The value.
+ * @return	The spread value.
+ */
+
+static int spreadBits(int x) {
+	x &= 0xF;
+	x = (x | (x << 4)) & 0x0C3;
+	x = (x | (x << 2)) & 0x249;
+	return x;
+}
+
+/**
+ * @fn	template <class T> static void gather(vector<T>& v, const vector<int>& order, vector<T>& scratch)
+ * @brief	Reorders v so that its i-th element becomes the old v[order[i]].
+ */
+
+template <class T>
+static void gather(vector<T>& v, const vector<int>& order, vector<T>& scratch) {
+	scratch.resize(v.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		scratch[i] = v[order[i]];
+	}
+	v.swap(scratch);
+}
+
+/**
+ * @fn	void RayQueue::sortCoherently()
+ * @brief	Sorts the rays so that neighbors in the queue are likely to traverse the
+ * 			same part of the BVH: by direction octant, then along a Morton curve
+ * 			through the origins (16 cells per axis of the queue's bounding box).
+ * 			Reflection and refraction rays leave surfaces in all directions, so
+ * 			without this consecutive rays have little in common. The sort is a
+ * 			stable two pass radix sort, so rays in the same cell keep their
+ * 			scanline order.
+ */
+
+void RayQueue::sortCoherently() {
+	int n = size();
+	if (n < 2) {
+		return;
+	}
+	dvec3 lo(DBL_MAX), hi(-DBL_MAX);
+	for (int i = 0; i < n; i++) {
+		dvec3 o(ox[i], oy[i], oz[i]);
+		lo = glm::min(lo, o);
+		hi = glm::max(hi, o);
+	}
+	dvec3 scale = dvec3(15.0) / glm::max(hi - lo, dvec3(1.0e-12));
+
+	vector<uint16_t> keys(n);
+	for (int i = 0; i < n; i++) {
+		dvec3 cell = (dvec3(ox[i], oy[i], oz[i]) - lo) * scale;
+		int octant = (dx[i] < 0 ? 1 : 0) | (dy[i] < 0 ? 2 : 0) | (dz[i] < 0 ? 4 : 0);
+		int morton = spreadBits((int)cell.x) | (spreadBits((int)cell.y) << 1) | (spreadBits((int)cell.z) << 2);
+		keys[i] = (uint16_t)((octant << 12) | morton);
+	}
+
+	vector<int> order(n), sorted(n);
+	for (int i = 0; i < n; i++) {
+		order[i] = i;
+	}
+	for (int shift = 0; shift < 16; shift += 8) {
+		int start[257] = { 0 };
+		for (int i = 0; i < n; i++) {
+			start[((keys[i] >> shift) & 0xFF) + 1]++;
+		}
+		for (int b = 0; b < 256; b++) {
+			start[b + 1] += start[b];
+		}
+		for (int i = 0; i < n; i++) {
+			sorted[start[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+		}
+		order.swap(sorted);
+	}
+
+	vector<double> scratch;
+	for (vector<double>* v : { &ox, &oy, &oz, &dx, &dy, &dz, &wr, &wg, &wb, &cone }) {
+		gather(*v, order, scratch);
+	}
+	vector<int> intScratch;
+	gather(pixel, order, intScratch);
+	gather(level, order, intScratch);
+}
@@ -0,0 +1,90 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <vector>
+#include "defs.h"
+#include "ishape.h"
+
+/**
+ * @struct	RayQueue
+ * @brief	One wave of rays for the wavefront integrator, in structure-of-arrays
+ * 			layout. Besides its origin and direction, each ray carries the pixel
+ * 			it contributes to, the weight its color is scaled by on the way there,
+ * 			the recursion level it was cast at and the width of its ray cone at
+ * 			its origin (see RayTracer::textureLOD).
+ */
+
+struct RayQueue {
+	vector<double> ox, oy, oz;		//!< origins
+	vector<double> dx, dy, dz;		//!< unit directions
+	vector<double> wr, wg, wb;		//!< weights
+	vector<int> pixel;				//!< pixel the ray contributes to
+	vector<int> level;				//!< recursion level
+	vector<double> cone;			//!< ray cone widths at the origins
+	void add(const dvec3& origin, const dvec3& dir, const color& weight, int pixel, int level, double coneWidth);
+	Ray ray(int i) const { return Ray(dvec3(ox[i], oy[i], oz[i]), dvec3(dx[i], dy[i], dz[i])); }
+	color weight(int i) const { return color(wr[i], wg[i], wb[i]); }
+	int size() const { return (int)pixel.size(); }
+	void clear();
+	void sortCoherently();
+};
+
+/**
+ * @struct	RayStackEntry
+ * @brief	A ray waiting on a RayStack, with the weight its color is scaled by,
+ * 			its recursion level and the width of its ray cone at its origin.
+ */
+
+struct RayStackEntry {
+	dvec3 origin;
+	dvec3 dir;
+	color weight;
+	int level;
+	double coneWidth;
+};
+
+/**
+ * @struct	RayStack
+ * @brief	The rays of one pixel sample that are still to be traced, for the
+ * 			iterative (depth first) tracer. Each ray traced pops one entry and
+ * 			pushes at most two one level down, so a depth of d never needs more
+ * 			than d + 1 entries. The first CAPACITY entries are stored in place,
+ * 			so tracing neither allocates nor recurses at ordinary depths; deeper
+ * 			stacks spill into a vector, and no ray is ever dropped.
+ */
+
+struct RayStack {
+	static const int CAPACITY = 64;		//!< entries stored in place; enough for recursion depths up to 63
+	RayStackEntry entries[CAPACITY];
+	vector<RayStackEntry> spilled;		//!< entries beyond CAPACITY, bottom first
+	int size = 0;						//!< entries in use
+	int maxSize = 0;					//!< the most entries in use at once
+	int numPushed = 0;					//!< rays pushed
+	bool empty() const { return size == 0; }
+	void push(const dvec3& origin, const dvec3& dir, const color& weight, int level, double coneWidth) {
+		RayStackEntry entry = { origin, dir, weight, level, coneWidth };
+		if (size < CAPACITY) {
+			entries[size] = entry;
+		} else {
+			spilled.push_back(entry);
+		}
+		size++;
+		numPushed++;
+		maxSize = glm::max(maxSize, size);
+	}
+	RayStackEntry pop() {
+		if (--size < CAPACITY) {
+			return entries[size];
+		}
+		RayStackEntry entry = spilled.back();
+		spilled.pop_back();
+		return entry;
+	}
+};
@@ -1,203 +1,894 @@
-/****************************************************
- * 2016-2024 Eric Bachmann and Mike Zmuda
- * All Rights Reserved.
- * NOTICE:
- * Dissemination of this information or reproduction
- * of this material is prohibited unless prior written
- * permission is granted.
- ****************************************************/
-#include "raytracer.h"
-#include "ishape.h"
-#include "io.h"
-
- /**
-  * @fn	RayTracer::RayTracer(const color &defa)
-  * @brief	Constructs a raytracers.
-  * @param	defa	The clear color.
-  */
-
-RayTracer::RayTracer(const color& defa)
-    : defaultColor(defa) {
-}
-
-/**
- * @fn	void RayTracer::raytraceScene(FrameBuffer &frameBuffer, int depth, const IScene &theScene) const
- * @brief	Raytrace scene
- * @param [in,out]	frameBuffer	Framebuffer.
- * @param 		  	depth	   	The current depth of recursion.
- * @param 		  	theScene   	The scene.
- */
-
-void RayTracer::raytraceScene(FrameBuffer& frameBuffer, int depth,
-    const IScene& theScene, int n) {
-    const RaytracingCamera& camera = *theScene.camera;
-    //const vector<VisibleIShapePtr>& objs = theScene.opaqueObjs;
-    const vector<LightSourcePtr>& lights = theScene.lights;
-    //color defaultColor = frameBuffer.getClearColor();
-    this->initialRecursionDepth = depth;
-
-    for (int y = 0; y < frameBuffer.getWindowHeight(); ++y) {
-        for (int x = 0; x < frameBuffer.getWindowWidth(); ++x) {
-            //DEBUG_PIXEL = (x == xDebug && y == yDebug);
-            //if (DEBUG_PIXEL) {
-            //    cout << "";
-            //}
-            if (n > 1) {
-                vector<Ray> rays = theScene.camera->getAARays(x, y, n);
-
-                color colorForPixel = black;
-                for (auto& ray : rays) {
-                    colorForPixel += traceIndividualRay(ray, theScene, depth);;
-                }
-
-                colorForPixel /= rays.size();
-                colorForPixel = glm::clamp(colorForPixel, 0.0, 1.0);
-                frameBuffer.setColor(x, y, colorForPixel);
-            }
-            else {
-                Ray ray = theScene.camera->getRay(x, y);
-                color colorForPixel = traceIndividualRay(ray, theScene, depth);
-                frameBuffer.setColor(x, y, colorForPixel);
-                frameBuffer.showAxes(x, y, ray, 0.25);
-            }
-        }
-    }
-
-    frameBuffer.showColorBuffer();
-}
-
-/**
- * @fn	color RayTracer::traceIndividualRay(const Ray &ray,
- *											const IScene &theScene,
- *											int recursionLevel) const
- * @brief	Trace an individual ray.
- * @param	ray			  	The ray.
- * @param	theScene	  	The scene.
- * @param	recursionLevel	The recursion level.
- * @return	The color to be displayed as a result of this ray.
- */
-
- /**
-  * @fn	static double fresnel(const dvec3& i, const dvec3& n, const double& etai, const double& etat)
-  *
-  * @brief	Compute Fresnel equation
-  *
-  * @param	i   	is the incident view direction.
-  * @param	n   	is the normal at the intersection point.
-  * @param	etai	is the refractive index of the material the light is leaving.
-  * @param	etat	is the refractive index of the material the light is entering.
-  *
-  * @returns	kr is the percentage of light reflected As a consequence of the conservation of
-  * 			energy, transmittance is given by: kt = 1 - kr
-  * 			https://www.scratchapixel.com/lessons/3d-basic-rendering/introduction-to-shading/reflection-refraction-fresnel
-  * 			http://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-overview/light-transport-ray-tracing-whitted
-  * 			https://graphics.stanford.edu/courses/cs148-10-summer/docs/2006--degreve--reflection_refraction.pdf.
-  * 			https://www.cs.cornell.edu/courses/cs4620/2012fa/lectures/36raytracing.pdf
-  */
-static double fresnel(const dvec3& i, const dvec3& n, const double& etai, const double& etat)
-{
-    // Percentage of light that is reflected
-    // Percentage of light that is refracted is equal to 1-kr
-    double kr;
-
-    // Calculate the dot product of the incidence vector and the normal 
-    // vector of the surface the the light is entering
-    double cosi = glm::clamp(-1.0, 1.0, glm::dot(i, n));
-
-    // Compute the sine of the angle of refraction using Snell's law
-    double sint = etai / etat * sqrt(glm::max(0.0, 1.0 - cosi * cosi));
-
-    // Check if angle of incidence exceeds critical angle 
-    if (sint >= 1.0) {
-        kr = 1.0; // Total internal reflection
-    }
-    else {
-        // Calculate the percentage of light that will be reflected
-        double cost = sqrt(glm::max(0.0, 1.0 - sint * sint));
-        cosi = fabs(cosi);
-        double Rs = ((etat * cosi) - (etai * cost)) / ((etai * cost) + (etat * cosi)); // S polarized light (parallel)
-        double Rp = ((etai * cosi) - (etat * cost)) / ((etat * cost) + (etai * cosi)); // P polarized light (perpendicular)
-        kr = (Rs * Rs + Rp * Rp) / 2.0;
-    }
-
-    return kr;
-
-}
-
-color RayTracer::traceIndividualRay(const Ray& ray, const IScene& theScene, int recursionLevel) const {
-    OpaqueHitRecord theHit;
-    theHit.t = FLT_MAX;
-    VisibleIShape::findIntersection(ray, theScene.opaqueObjs, theHit);
-
-    if (theHit.t < FLT_MAX) {
-        color totalColor = black;
-
-        if (theHit.texture != nullptr) {
-            color texelColor = theHit.texture->getPixelUV(theHit.u, theHit.v);
-            theHit.material.ambient = 0.15 * texelColor;
-            theHit.material.diffuse = texelColor;
-        }
-
-        if (!theHit.material.isDielectric) {
-            for (auto& light : theScene.lights) {
-                bool inShadow = light->pointIsInAShadow(theHit.interceptPt, theHit.normal, theScene.opaqueObjs, theScene.camera->getFrame());
-                totalColor += light->illuminate(theHit.interceptPt, theHit.normal, theHit.material, theScene.camera->getFrame(), inShadow);
-            }
-        }
-
-        if (recursionLevel > 0) {
-            if (theHit.material.isDielectric) {
-                double etai, etat;
-                if (theHit.rayStatus == ENTERING) {
-                    etai = 1.0;
-                    etat = theHit.material.dielectricRefractionIndex;
-                }
-                else {
-                    etai = theHit.material.dielectricRefractionIndex;
-                    etat = 1.0;
-                }
-
-                double kr = fresnel(ray.dir, theHit.normal, etai, etat);
-                double kt = 1.0 - kr;
-
-                dvec3 reflectionDir = glm::reflect(ray.dir, theHit.normal);
-                Ray reflectionRay(theHit.interceptPt + EPSILON * theHit.normal, reflectionDir);
-                color reflectionColor = traceIndividualRay(reflectionRay, theScene, recursionLevel - 1);
-
-                color refractionColor = black;
-
-                if (kr < 1.0) {
-                    Ray refractionRay(theHit.interceptPt - EPSILON * theHit.normal, ray.dir);
-                    refractionColor = traceIndividualRay(refractionRay, theScene, recursionLevel - 1);
-
-                    color tint = color(1.3, 0.9, 0.9);
-                    refractionColor = refractionColor * tint;
-                }
-                totalColor = kr * reflectionColor + kt * refractionColor;
-            }
-
-
-            else {
-                dvec3 reflectionDir = glm::reflect(ray.dir, theHit.normal);
-                Ray reflectionRay(theHit.interceptPt + EPSILON * theHit.normal, reflectionDir);
-                totalColor += 0.5 * traceIndividualRay(reflectionRay, theScene, recursionLevel - 1);
-
-                if (theHit.material.alpha < 1.0) {
-                    Ray transparentRay(theHit.interceptPt - EPSILON * theHit.normal, ray.dir);
-                    color transparentColor = traceIndividualRay(transparentRay, theScene, recursionLevel - 1);
-                    totalColor = theHit.material.alpha * totalColor + (1.0 - theHit.material.alpha) * transparentColor;
-                }
-            }
-        }
-        else if (theHit.material.isDielectric) {
-            Ray transparentRay(theHit.interceptPt - EPSILON * theHit.normal, ray.dir);
-            color throughColor = traceIndividualRay(transparentRay, theScene, 0);
-
-            color tint = color(1.3, 0.9, 0.9);
-            totalColor = throughColor * tint;
-        }
-
-        return totalColor;
-    }
-    return (recursionLevel == initialRecursionDepth) ? defaultColor : defaultColor * 0.1;
-}
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+#include <algorithm>
+#include <random>
+#include "raytracer.h"
+#include "ishape.h"
+#include "io.h"
+
+// Rays cast by the calling thread. Tiles fold this into raysTraced when they
+// finish, which keeps the shared counter out of the inner loop.
+static thread_local size_t raysCastByThread = 0;
+
+ /**
+  * @fn	RayTracer::RayTracer(const color &defa)
+  * @brief	Constructs a raytracers.
+  * @param	defa	The clear color.
+  */
+
+RayTracer::RayTracer(const color& defa)
+    : defaultColor(defa) {
+}
+
+/**
+ * @fn	void RayTracer::setTiling(int tileSize, int numThreads)
+ * @brief	Selects tiled, multithreaded rendering. The framebuffer is split into
+ * 			tileSize x tileSize tiles, which are rendered by a persistent
+ * 			thread pool. Passing tileSize = 0 returns to serial rendering.
+ * @param	tileSize  	Width and height of a tile, in pixels.
+ * @param	numThreads	Number of threads. Values < 1 select one thread per core.
+ */
+
+void RayTracer::setTiling(int tileSize, int numThreads) {
+    this->tileSize = glm::max(tileSize, 0);
+    this->numThreads = numThreads;
+}
+
+/**
+ * @fn	void RayTracer::raytraceScene(FrameBuffer &frameBuffer, int depth, IScene &theScene)
+ * @brief	Raytrace scene. The scene is committed first, so objects may be moved
+ * 			freely between frames.
+ * @param [in,out]	frameBuffer	Framebuffer.
+ * @param 		  	depth	   	The current depth of recursion.
+ * @param [in,out]	theScene   	The scene.
+ */
+
+void RayTracer::raytraceScene(FrameBuffer& frameBuffer, int depth,
+    IScene& theScene, int n) {
+    theScene.commit(singlePrecision, lightCutoff);
+    setupRayCones(*theScene.camera);
+    this->initialRecursionDepth = depth;
+    raysTraced = 0;
+
+    forEachTile(frameBuffer, [&](int left, int bottom, int right, int top) {
+        raytraceRect(frameBuffer, left, bottom, right, top, theScene, n);
+        });
+
+    frameBuffer.showColorBuffer();
+}
+
+/**
+ * @fn	void RayTracer::raytracePass(FrameBuffer& frameBuffer, int depth, IScene& theScene, int pass, int n)
+ * @brief	Renders one pass of a progressive frame. Pass 0 traces every 8th pixel
+ * 			in each direction and fills the 8x8 block above and to the right of it;
+ * 			each later pass halves the spacing, tracing only pixels that earlier
+ * 			passes skipped, so after NUM_PASSES passes every pixel has been traced
+ * 			exactly once. The picture is usable after every pass. A caller that
+ * 			sees the scene change simply starts over at pass 0, discarding the
+ * 			passes still to come. Antialiasing is only done in the last pass,
+ * 			which then re-traces the whole frame.
+ * @param [in,out]	frameBuffer	Framebuffer.
+ * @param 		  	depth	   	The recursion depth.
+ * @param [in,out]	theScene   	The scene. Committed by pass 0.
+ * @param 		  	pass	   	Which pass, 0 to NUM_PASSES - 1.
+ * @param 		  	n		   	Antialiasing level.
+ */
+
+void RayTracer::raytracePass(FrameBuffer& frameBuffer, int depth,
+    IScene& theScene, int pass, int n) {
+    if (pass == 0) {
+        theScene.commit(singlePrecision, lightCutoff);
+        setupRayCones(*theScene.camera);
+        raysTraced = 0;
+    }
+    this->initialRecursionDepth = depth;
+    int stride = 1 << (NUM_PASSES - 1 - pass);
+
+    forEachTile(frameBuffer, [&](int left, int bottom, int right, int top) {
+        if (stride == 1 && n > 1) {
+            raytraceRect(frameBuffer, left, bottom, right, top, theScene, n);
+        }
+        else {
+            raytraceSparseRect(frameBuffer, left, bottom, right, top, theScene, stride);
+        }
+        });
+
+    frameBuffer.showColorBuffer();
+}
+
+/**
+ * @fn	void RayTracer::forEachTile(const FrameBuffer& frameBuffer, const std::function<void(int left, int bottom, int right, int top)>& renderRect)
+ * @brief	Calls renderRect for every tile of the framebuffer, on the thread pool
+ * 			when tiling is on, or once for the whole frame when it is off. Tiles
+ * 			never overlap, so any number of them can be written at once. Rays cast
+ * 			are added to raysTraced.
+ * @param	frameBuffer	Framebuffer.
+ * @param	renderRect 	Renders [left, right) x [bottom, top).
+ */
+
+void RayTracer::forEachTile(const FrameBuffer& frameBuffer,
+    const std::function<void(int left, int bottom, int right, int top)>& renderRect) {
+    int width = frameBuffer.getWindowWidth();
+    int height = frameBuffer.getWindowHeight();
+    if (tileSize > 0) {
+        int threadsWanted = numThreads > 0 ? numThreads : ThreadPool::defaultNumThreads();
+        if (pool == nullptr || pool->getNumThreads() != threadsWanted) {
+            pool.reset(new ThreadPool(threadsWanted));
+        }
+        int tilesAcross = (width + tileSize - 1) / tileSize;
+        int tilesDown = (height + tileSize - 1) / tileSize;
+        pool->parallelFor(tilesAcross * tilesDown, [&](int tileIndex) {
+            int left = (tileIndex % tilesAcross) * tileSize;
+            int bottom = (tileIndex / tilesAcross) * tileSize;
+            size_t raysBefore = raysCastByThread;
+            renderRect(left, bottom, glm::min(left + tileSize, width), glm::min(bottom + tileSize, height));
+            raysTraced += raysCastByThread - raysBefore;
+            });
+    }
+    else {
+        size_t raysBefore = raysCastByThread;
+        renderRect(0, 0, width, height);
+        raysTraced += raysCastByThread - raysBefore;
+    }
+}
+
+/**
+ * @fn	void RayTracer::raytraceSparseRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top, const IScene& theScene, int stride) const
+ * @brief	Traces the pixels of [left, right) x [bottom, top) whose coordinates are
+ * 			multiples of stride, but not both multiples of 2 * stride (those were
+ * 			traced by the previous pass), and fills a stride x stride block with
+ * 			each one's color. The blocks only cover pixels that this pass does not
+ * 			trace, so tiles may spill into their neighbors safely.
+ * @param [in,out]	frameBuffer	Framebuffer.
+ * @param 		  	left	   	First column.
+ * @param 		  	bottom	   	First row.
+ * @param 		  	right	   	One past the last column.
+ * @param 		  	top		   	One past the last row.
+ * @param 		  	theScene   	The scene.
+ * @param 		  	stride	   	Spacing of the pixels traced.
+ */
+
+void RayTracer::raytraceSparseRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top,
+    const IScene& theScene, int stride) const {
+    const bool firstPass = stride == 1 << (NUM_PASSES - 1);
+    int x0 = (left + stride - 1) / stride * stride;
+    int y0 = (bottom + stride - 1) / stride * stride;
+    for (int y = y0; y < top; y += stride) {
+        for (int x = x0; x < right; x += stride) {
+            if (!firstPass && x % (2 * stride) == 0 && y % (2 * stride) == 0) {
+                continue;
+            }
+            Ray ray = theScene.camera->getRay(x, y);
+            color colorForPixel = traceIndividualRay(ray, theScene, initialRecursionDepth);
+            for (int j = y; j < y + stride; j++) {
+                for (int i = x; i < x + stride; i++) {
+                    frameBuffer.setColor(i, j, colorForPixel);
+                }
+            }
+            frameBuffer.showAxes(x, y, ray, 0.25);
+        }
+    }
+}
+
+/**
+ * @fn	void RayTracer::raytraceRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top, const IScene& theScene, int n) const
+ * @brief	Raytraces the pixels in [left, right) x [bottom, top). Without
+ * 			antialiasing, the primary rays are traced in 2x2 packets. With
+ * 			useWavefront set, the rect is traced one wave at a time instead.
+ * @param [in,out]	frameBuffer	Framebuffer.
+ * @param 		  	left	   	First column.
+ * @param 		  	bottom	   	First row.
+ * @param 		  	right	   	One past the last column.
+ * @param 		  	top		   	One past the last row.
+ * @param 		  	theScene   	The scene.
+ * @param 		  	n		   	Antialiasing level.
+ */
+
+void RayTracer::raytraceRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top,
+    const IScene& theScene, int n) const {
+    if (useWavefront) {
+        raytraceWavefrontRect(frameBuffer, left, bottom, right, top, theScene, n);
+    }
+    else if (usePackets && n == 1) {
+        for (int y = bottom; y < top; y += 2) {
+            for (int x = left; x < right; x += 2) {
+                raytraceQuad(frameBuffer, x, y, right, top, theScene);
+            }
+        }
+    }
+    else {
+        for (int y = bottom; y < top; ++y) {
+            for (int x = left; x < right; ++x) {
+                raytracePixel(frameBuffer, x, y, theScene, n);
+            }
+        }
+    }
+}
+
+/**
+ * @fn	void RayTracer::raytraceQuad(FrameBuffer& frameBuffer, int x, int y, int right, int top, const IScene& theScene) const
+ * @brief	Raytraces the 2x2 block of pixels whose lower left corner is (x, y), with
+ * 			the four primary rays intersected as one packet. Pixels at or beyond
+ * 			right/top are left out. Gives the same colors as raytracePixel.
+ * @param [in,out]	frameBuffer	Framebuffer.
+ * @param 		  	x		   	The x coordinate.
+ * @param 		  	y		   	The y coordinate.
+ * @param 		  	right	   	One past the last column that may be written.
+ * @param 		  	top		   	One past the last row that may be written.
+ * @param 		  	theScene   	The scene.
+ */
+
+void RayTracer::raytraceQuad(FrameBuffer& frameBuffer, int x, int y, int right, int top, const IScene& theScene) const {
+    // Lanes are (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1). At the right/top
+    // edges the missing pixels repeat an existing one and their lanes are masked off.
+    int x1 = glm::min(x + 1, right - 1);
+    int y1 = glm::min(y + 1, top - 1);
+    const int px[PACKET_SIZE] = { x, x1, x, x1 };
+    const int py[PACKET_SIZE] = { y, y, y1, y1 };
+    int lanes = 1;
+    if (x1 > x) lanes |= 1 << 1;
+    if (y1 > y) lanes |= 1 << 2;
+    if (x1 > x && y1 > y) lanes |= 1 << 3;
+    Ray rays[PACKET_SIZE] = { theScene.camera->getRay(px[0], py[0]), theScene.camera->getRay(px[1], py[1]),
+                              theScene.camera->getRay(px[2], py[2]), theScene.camera->getRay(px[3], py[3]) };
+
+    RayPacket packet(rays, PACKET_SIZE);
+    packet.activeLanes = lanes;
+    OpaqueHitRecord hits[PACKET_SIZE];
+    theScene.findClosestIntersections(packet, hits);
+
+    for (int i = 0; i < PACKET_SIZE; i++) {
+        if ((lanes & (1 << i)) == 0) {
+            continue;
+        }
+        raysCastByThread++;
+        color colorForPixel = shadeHit(rays[i], hits[i], theScene, initialRecursionDepth);
+        frameBuffer.setColor(px[i], py[i], colorForPixel);
+        frameBuffer.showAxes(px[i], py[i], rays[i], 0.25);
+    }
+}
+
+/**
+ * @fn	void RayTracer::raytracePixel(FrameBuffer& frameBuffer, int x, int y, const IScene& theScene, int n) const
+ * @brief	Computes the color of a single pixel and stores it in the framebuffer.
+ * 			Only touches pixel (x, y), so it is safe to call from several threads.
+ * @param [in,out]	frameBuffer	Framebuffer.
+ * @param 		  	x		   	The x coordinate.
+ * @param 		  	y		   	The y coordinate.
+ * @param 		  	theScene   	The scene.
+ * @param 		  	n		   	Antialiasing level.
+ */
+
+void RayTracer::raytracePixel(FrameBuffer& frameBuffer, int x, int y, const IScene& theScene, int n) const {
+    const int depth = initialRecursionDepth;
+    //DEBUG_PIXEL = (x == xDebug && y == yDebug);
+    //if (DEBUG_PIXEL) {
+    //    cout << "";
+    //}
+    if (n > 1) {
+        int m = theScene.camera->getAAGridSize(n);
+        color colorForPixel = black;
+        if (aaThreshold > 0.0 && m > 2) {
+            colorForPixel = raytraceAdaptivePixel(x, y, theScene, m);
+        } else {
+            for (int i = 0; i < m; ++i) {
+                for (int j = 0; j < m; ++j) {
+                    colorForPixel += traceIndividualRay(theScene.camera->getAARay(x, y, i, j, m), theScene, depth);
+                }
+            }
+            colorForPixel /= m * m;
+        }
+
+        colorForPixel = glm::clamp(colorForPixel, 0.0, 1.0);
+        frameBuffer.setColor(x, y, colorForPixel);
+    }
+    else {
+        Ray ray = theScene.camera->getRay(x, y);
+        color colorForPixel = traceIndividualRay(ray, theScene, depth);
+        frameBuffer.setColor(x, y, colorForPixel);
+        frameBuffer.showAxes(x, y, ray, 0.25);
+    }
+}
+
+/**
+ * @fn	color RayTracer::raytraceAdaptivePixel(int x, int y, const IScene& theScene, int m) const
+ * @brief	Adaptive antialiasing. Traces the four corner cells of an m x m grid over
+ * 			the pixel; if they see different objects, or any color channel varies by
+ * 			more than aaThreshold, the rest of the grid is traced as well. Flat
+ * 			regions therefore cost 4 rays instead of m * m.
+ * @param	x			The x coordinate.
+ * @param	y			The y coordinate.
+ * @param	theScene	The scene.
+ * @param	m			Cells per side; m * m is the most rays the pixel gets.
+ * @return	The average color of the samples taken (unclamped).
+ */
+
+color RayTracer::raytraceAdaptivePixel(int x, int y, const IScene& theScene, int m) const {
+    const int corners[4][2] = { { 0, 0 }, { 0, m - 1 }, { m - 1, 0 }, { m - 1, m - 1 } };
+    color sum = black;
+    color lo(DBL_MAX), hi(-DBL_MAX);
+    const VisibleIShape* firstObject = nullptr;
+    bool sameObject = true;
+    for (int k = 0; k < 4; k++) {
+        const VisibleIShape* object;
+        Ray ray = theScene.camera->getAARay(x, y, corners[k][0], corners[k][1], m);
+        color c = tracePrimaryRay(ray, theScene, object);
+        sum += c;
+        lo = glm::min(lo, c);
+        hi = glm::max(hi, c);
+        if (k == 0) {
+            firstObject = object;
+        } else if (object != firstObject) {
+            sameObject = false;
+        }
+    }
+
+    color spread = hi - lo;
+    double maxSpread = glm::max(spread.r, glm::max(spread.g, spread.b));
+    if (sameObject && maxSpread <= aaThreshold) {
+        return sum / 4.0;
+    }
+
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < m; ++j) {
+            bool isCorner = (i == 0 || i == m - 1) && (j == 0 || j == m - 1);
+            if (!isCorner) {
+                sum += traceIndividualRay(theScene.camera->getAARay(x, y, i, j, m), theScene, initialRecursionDepth);
+            }
+        }
+    }
+    return sum / (double)(m * m);
+}
+
+ /**
+  * @fn	static double fresnel(const dvec3& i, const dvec3& n, const double& etai, const double& etat)
+  *
+  * @brief	Compute Fresnel equation
+  *
+  * @param	i   	is the incident view direction.
+  * @param	n   	is the normal at the intersection point.
+  * @param	etai	is the refractive index of the material the light is leaving.
+  * @param	etat	is the refractive index of the material the light is entering.
+  *
+  * @returns	kr is the percentage of light reflected As a consequence of the conservation of
+  * 			energy, transmittance is given by: kt = 1 - kr
+  * 			https://www.scratchapixel.com/lessons/3d-basic-rendering/introduction-to-shading/reflection-refraction-fresnel
+  * 			http://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-overview/light-transport-ray-tracing-whitted
+  * 			https://graphics.stanford.edu/courses/cs148-10-summer/docs/2006--degreve--reflection_refraction.pdf.
+  * 			https://www.cs.cornell.edu/courses/cs4620/2012fa/lectures/36raytracing.pdf
+  */
+static double fresnel(const dvec3& i, const dvec3& n, const double& etai, const double& etat)
+{
+    // Percentage of light that is reflected
+    // Percentage of light that is refracted is equal to 1-kr
+    double kr;
+
+    // Calculate the dot product of the incidence vector and the normal 
+    // vector of the surface the the light is entering
+    double cosi = glm::clamp(-1.0, 1.0, glm::dot(i, n));
+
+    // Compute the sine of the angle of refraction using Snell's law
+    double sint = etai / etat * sqrt(glm::max(0.0, 1.0 - cosi * cosi));
+
+    // Check if angle of incidence exceeds critical angle 
+    if (sint >= 1.0) {
+        kr = 1.0; // Total internal reflection
+    }
+    else {
+        // Calculate the percentage of light that will be reflected
+        double cost = sqrt(glm::max(0.0, 1.0 - sint * sint));
+        cosi = fabs(cosi);
+        double Rs = ((etat * cosi) - (etai * cost)) / ((etai * cost) + (etat * cosi)); // S polarized light (parallel)
+        double Rp = ((etai * cosi) - (etat * cost)) / ((etat * cost) + (etai * cosi)); // P polarized light (perpendicular)
+        kr = (Rs * Rs + Rp * Rp) / 2.0;
+    }
+
+    return kr;
+
+}
+
+/**
+ * @fn	static double randomDraw()
+ * @brief	A uniformly distributed number in [0, 1), for Russian roulette and
+ * 			light sampling. Each thread has its own generator.
+ * @return	The number.
+ */
+
+static double randomDraw() {
+    static thread_local std::minstd_rand generator;
+    return std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+}
+
+/**
+ * @fn	template <class Spawn> color RayTracer::scatter(const dvec3& dir, OpaqueHitRecord& theHit, int recursionLevel, const color& weight, double coneWidth, Spawn spawn) const
+ * @brief	The rules of the Whitted model for what a hit sends on: the
+ * 			reflection, refraction and transparency rays it spawns, and how much
+ * 			of the direct light at the hit counts. Every ray is weighted by what
+ * 			the color seen along it is multiplied by on its way to the pixel, so
+ * 			callers can trace the spawned rays in any order and simply add up
+ * 			weighted colors. Opaque hits reflect with their material's
+ * 			reflectivity. Rays that would weigh no more than minRayWeight are
+ * 			not spawned at all, and with russianRoulette set a dielectric
+ * 			follows either its reflection (with probability kr) or its
+ * 			refraction, at a weight that keeps the expected color the same.
+ * 			Textures are resolved into theHit's material, filtered over the
+ * 			ray cone's footprint. Spawned rays start out as wide as that
+ * 			footprint (surface curvature is ignored).
+ * @param 		  	dir			  	Direction of the ray that made the hit.
+ * @param [in,out]	theHit		  	The hit.
+ * @param 		  	recursionLevel	Recursion level of the ray that made the hit.
+ * @param 		  	weight		  	Weight of the ray that made the hit.
+ * @param 		  	coneWidth	  	Width of the ray's cone at its origin.
+ * @param 		  	spawn		  	Called as spawn(origin, dir, weight, recursionLevel, coneWidth) for each new ray.
+ * @return	The weight of the direct light at the hit (black if it gets none).
+ */
+
+template <class Spawn>
+color RayTracer::scatter(const dvec3& dir, OpaqueHitRecord& theHit, int recursionLevel,
+    const color& weight, double coneWidth, Spawn spawn) const {
+    const color tint = color(1.3, 0.9, 0.9);
+    const double footprint = coneWidth + coneSpread * theHit.t;
+    auto spawnIfVisible = [&](const dvec3& origin, const dvec3& newDir, const color& newWeight, int level) {
+        if (glm::max(newWeight.r, glm::max(newWeight.g, newWeight.b)) > minRayWeight) {
+            spawn(origin, newDir, newWeight, level, footprint);
+        }
+    };
+    if (theHit.texture != nullptr) {
+        double lod = textureFilter == NEAREST_FILTER ? 0.0 : textureLOD(dir, theHit, footprint);
+        color texelColor = theHit.texture->sampleUV(theHit.u, theHit.v, lod, textureFilter);
+        theHit.material.ambient = 0.15 * texelColor;
+        theHit.material.diffuse = texelColor;
+    }
+
+    const Material& material = theHit.material;
+    const dvec3 abovePt = theHit.interceptPt + EPSILON * theHit.normal;
+    const dvec3 belowPt = theHit.interceptPt - EPSILON * theHit.normal;
+    if (recursionLevel > 0) {
+        if (material.isDielectric) {
+            double etai, etat;
+            if (theHit.rayStatus == ENTERING) {
+                etai = 1.0;
+                etat = material.dielectricRefractionIndex;
+            }
+            else {
+                etai = material.dielectricRefractionIndex;
+                etat = 1.0;
+            }
+            double kr = fresnel(dir, theHit.normal, etai, etat);
+            if (russianRoulette && kr < 1.0) {
+                if (randomDraw() < kr) {
+                    spawnIfVisible(abovePt, glm::reflect(dir, theHit.normal), weight, recursionLevel - 1);
+                }
+                else {
+                    spawnIfVisible(belowPt, dir, tint * weight, recursionLevel - 1);
+                }
+                return black;
+            }
+            spawnIfVisible(abovePt, glm::reflect(dir, theHit.normal), kr * weight, recursionLevel - 1);
+            if (kr < 1.0) {
+                spawnIfVisible(belowPt, dir, (1.0 - kr) * tint * weight, recursionLevel - 1);
+            }
+            return black;
+        }
+        double opacity = material.alpha < 1.0 ? material.alpha : 1.0;
+        spawnIfVisible(abovePt, glm::reflect(dir, theHit.normal), material.reflectivity * opacity * weight, recursionLevel - 1);
+        if (material.alpha < 1.0) {
+            spawnIfVisible(belowPt, dir, (1.0 - material.alpha) * weight, recursionLevel - 1);
+        }
+        return opacity * weight;
+    }
+    if (material.isDielectric) {
+        spawnIfVisible(belowPt, dir, tint * weight, 0);
+        return black;
+    }
+    return weight;
+}
+
+/**
+ * @fn	static double wrapDelta(double d)
+ * @brief	A difference of texture coordinates, taken the short way around, so a
+ * 			footprint straddling the seam of a wrapped texture stays small.
+ * @param	d	The difference.
+ * @return	The equivalent difference in [-0.5, 0.5].
+ */
+
+static double wrapDelta(double d) {
+    return d - glm::floor(d + 0.5);
+}
+
+/**
+ * @fn	double RayTracer::textureLOD(const dvec3& dir, const OpaqueHitRecord& theHit, double footprint) const
+ * @brief	Texture level of detail at a hit, from the ray cone's footprint: how
+ * 			far (u, v) moves when the hit point moves by the footprint's width in
+ * 			two directions across the surface. The width is stretched by
+ * 			1 / cos of the angle of incidence, as the cone's cross section is on a
+ * 			tilted surface.
+ * @param	dir		 	Direction of the ray that made the hit.
+ * @param	theHit   	The hit; must be textured.
+ * @param	footprint	Width of the ray cone at the hit.
+ * @return	The level of detail (see Image::levelOfDetail).
+ */
+
+double RayTracer::textureLOD(const dvec3& dir, const OpaqueHitRecord& theHit, double footprint) const {
+    if (footprint <= 0.0 || theHit.object == nullptr) {
+        return 0.0;
+    }
+    double cosine = glm::max(glm::abs(glm::dot(dir, theHit.normal)), 0.1);
+    double width = footprint / cosine;
+    dvec3 tangent = glm::normalize(glm::cross(theHit.normal, glm::abs(theHit.normal.x) < 0.9 ? X_AXIS : Y_AXIS));
+    dvec3 bitangent = glm::cross(theHit.normal, tangent);
+    const IShape* shape = theHit.object->shape;
+    dvec2 uv1, uv2;
+    shape->getTexCoords(theHit.interceptPt + width * tangent, uv1.x, uv1.y);
+    shape->getTexCoords(theHit.interceptPt + width * bitangent, uv2.x, uv2.y);
+    dvec2 d1(wrapDelta(uv1.x - theHit.u), wrapDelta(uv1.y - theHit.v));
+    dvec2 d2(wrapDelta(uv2.x - theHit.u), wrapDelta(uv2.y - theHit.v));
+    return theHit.texture->levelOfDetail(d1, d2);
+}
+
+/**
+ * @fn	void RayTracer::setupRayCones(const RaytracingCamera& camera)
+ * @brief	Measures the camera's ray cones: how wide a camera ray's cone starts
+ * 			out, and by what angle every cone widens, taken from two neighboring
+ * 			pixels at the center of the image.
+ * @param	camera	The camera.
+ */
+
+void RayTracer::setupRayCones(const RaytracingCamera& camera) {
+    double x = camera.getNX() / 2.0;
+    double y = camera.getNY() / 2.0;
+    Ray a = camera.getRay(x, y);
+    Ray b = camera.getRay(x + 1.0, y);
+    primaryConeWidth = glm::distance(a.origin, b.origin);
+    coneSpread = glm::length(b.dir - a.dir);  // chord length, i.e., the angle for angles this small
+}
+
+/**
+ * @fn	color RayTracer::traceIndividualRay(const Ray &ray, const IScene &theScene, int recursionLevel) const
+ * @brief	Trace an individual ray, and the rays it spawns, without recursion.
+ * @param	ray			  	The ray.
+ * @param	theScene	  	The scene.
+ * @param	recursionLevel	The recursion level.
+ * @return	The color to be displayed as a result of this ray.
+ */
+
+color RayTracer::traceIndividualRay(const Ray& ray, const IScene& theScene, int recursionLevel) const {
+    RayStack stack;
+    stack.push(ray.origin, ray.dir, white, recursionLevel, primaryConeWidth);
+    return traceRayStack(stack, theScene);
+}
+
+/**
+ * @fn	color RayTracer::traceRayStack(RayStack& stack, const IScene& theScene) const
+ * @brief	Traces the rays on a stack until it is empty. Each ray popped is
+ * 			intersected and shaded, and the rays its hit spawns (see scatter) are
+ * 			pushed, so a pixel's tree of rays is walked depth first, exactly like
+ * 			the recursive formulation, but without using the C++ stack. The
+ * 			stack's counters are left for the caller to inspect.
+ * @param [in,out]	stack   	Weighted rays to trace.
+ * @param 		  	theScene	The scene.
+ * @return	The sum of the weighted colors seen along the rays.
+ */
+
+color RayTracer::traceRayStack(RayStack& stack, const IScene& theScene) const {
+    color totalColor = black;
+    while (!stack.empty()) {
+        RayStackEntry entry = stack.pop();
+        Ray ray(entry.origin, entry.dir);
+        OpaqueHitRecord theHit;
+        theHit.t = FLT_MAX;
+        raysCastByThread++;
+        theScene.findClosestIntersection(ray, theHit);
+        totalColor += shadeHit(ray, theHit, theScene, entry.level, entry.weight, entry.coneWidth, stack);
+    }
+    return totalColor;
+}
+
+/**
+ * @fn	color RayTracer::tracePrimaryRay(const Ray& ray, const IScene& theScene, const VisibleIShape*& object) const
+ * @brief	Traces a ray from the camera, also reporting which object it hit.
+ * @param 		  	ray			The ray.
+ * @param 		  	theScene	The scene.
+ * @param [out]		object  	The object hit first, nullptr if none.
+ * @return	The color seen along the ray.
+ */
+
+color RayTracer::tracePrimaryRay(const Ray& ray, const IScene& theScene, const VisibleIShape*& object) const {
+    OpaqueHitRecord theHit;
+    theHit.t = FLT_MAX;
+    raysCastByThread++;
+    theScene.findClosestIntersection(ray, theHit);
+    object = theHit.t < FLT_MAX ? theHit.object : nullptr;
+    return shadeHit(ray, theHit, theScene, initialRecursionDepth);
+}
+
+/**
+ * @fn	color RayTracer::shadeHit(const Ray& ray, OpaqueHitRecord& theHit, const IScene& theScene, int recursionLevel) const
+ * @brief	Computes the color seen along a ray, once its closest hit is known.
+ * @param 		  	ray			  	The ray.
+ * @param [in,out]	theHit		  	The closest hit. t == FLT_MAX ==> nothing was hit.
+ * @param 		  	theScene	  	The scene.
+ * @param 		  	recursionLevel	The recursion level.
+ * @return	The color to be displayed as a result of this ray.
+ */
+
+color RayTracer::shadeHit(const Ray& ray, OpaqueHitRecord& theHit, const IScene& theScene, int recursionLevel) const {
+    RayStack stack;
+    color totalColor = shadeHit(ray, theHit, theScene, recursionLevel, white, primaryConeWidth, stack);
+    return totalColor + traceRayStack(stack, theScene);
+}
+
+/**
+ * @fn	color RayTracer::shadeHit(const Ray& ray, OpaqueHitRecord& theHit, const IScene& theScene, int recursionLevel, const color& weight, double coneWidth, RayStack& stack) const
+ * @brief	Computes the weighted color a hit contributes directly (background or
+ * 			direct light) and pushes the rays it spawns.
+ * @param 		  	ray			  	The ray.
+ * @param [in,out]	theHit		  	The closest hit. t == FLT_MAX ==> nothing was hit.
+ * @param 		  	theScene	  	The scene.
+ * @param 		  	recursionLevel	The recursion level.
+ * @param 		  	weight		  	Weight of the ray.
+ * @param 		  	coneWidth	  	Width of the ray's cone at its origin.
+ * @param [in,out]	stack		  	Where spawned rays go.
+ * @return	The weighted color contributed by the hit itself.
+ */
+
+color RayTracer::shadeHit(const Ray& ray, OpaqueHitRecord& theHit, const IScene& theScene, int recursionLevel,
+    const color& weight, double coneWidth, RayStack& stack) const {
+    if (theHit.t == FLT_MAX) {
+        return weight * ((recursionLevel == initialRecursionDepth) ? defaultColor : defaultColor * 0.1);
+    }
+    color directWeight = scatter(ray.dir, theHit, recursionLevel, weight, coneWidth,
+        [&](const dvec3& origin, const dvec3& dir, const color& w, int level, double cone) {
+            stack.push(origin, dir, w, level, cone);
+        });
+    if (directWeight == black) {
+        return black;
+    }
+    return directWeight * directLight(theHit, theScene);
+}
+
+/**
+ * @struct	LightCandidate
+ * @brief	A light that may light a hit, for light sampling.
+ */
+
+struct LightCandidate {
+    LightSourcePtr light;
+    color unshadowed;   //!< what the light adds if the hit is not in its shadow
+    double weight;      //!< chance of being picked, up to a factor
+    double cumulative;  //!< summed weights of the candidates up to this one
+};
+
+/**
+ * @fn	color RayTracer::directLight(const OpaqueHitRecord& theHit, const IScene& theScene) const
+ * @brief	The light reaching a hit straight from the light sources. Only the
+ * 			lights the scene's light tree finds for the hit's position are shadow
+ * 			tested. With lightSamples > 0 and more candidate lights than that,
+ * 			what each light adds when unshadowed is computed first (that is
+ * 			cheap) and only lightSamples lights, picked in proportion to it, are
+ * 			shadow tested. Each picked light counts 1 / (lightSamples * chance
+ * 			of being picked) times, so the expected color is exact; only the
+ * 			shadows are noisy.
+ * @param	theHit  	The hit.
+ * @param	theScene	The scene.
+ * @return	The direct light, ambient terms included.
+ */
+
+color RayTracer::directLight(const OpaqueHitRecord& theHit, const IScene& theScene) const {
+    const Frame& frame = theScene.camera->getFrame();
+    const LightTree& lightTree = theScene.lightTree;
+    const dvec3& p = theHit.interceptPt;
+    const dvec3& n = theHit.normal;
+    const Material& material = theHit.material;
+    color directColor = lightTree.ambient(material);
+
+    if (lightSamples <= 0) {
+        lightTree.forEachLight(p, [&](const LightVolume& volume) {
+            raysCastByThread++;
+            bool inShadow = volume.light->pointIsInAShadow(p, n, theScene, frame);
+            if (!volume.ambientIsSummed) {
+                directColor += volume.light->illuminate(p, n, material, frame, inShadow);
+            } else if (!inShadow) {
+                directColor += volume.light->illuminate(p, n, material, frame, false) -
+                    volume.light->illuminate(p, n, material, frame, true);
+            }
+            });
+        return directColor;
+    }
+
+    static thread_local vector<LightCandidate> candidates;
+    candidates.clear();
+    double totalWeight = 0.0;
+    lightTree.forEachLight(p, [&](const LightVolume& volume) {
+        color shadowed = volume.light->illuminate(p, n, material, frame, true);
+        color unshadowed = volume.light->illuminate(p, n, material, frame, false) - shadowed;
+        if (!volume.ambientIsSummed) {
+            directColor += shadowed;
+        }
+        double weight = unshadowed.r + unshadowed.g + unshadowed.b;
+        if (weight > 0.0) {
+            totalWeight += weight;
+            candidates.push_back({ volume.light, unshadowed, weight, totalWeight });
+        }
+        });
+
+    if ((int)candidates.size() <= lightSamples) {
+        for (const LightCandidate& candidate : candidates) {
+            raysCastByThread++;
+            if (!candidate.light->pointIsInAShadow(p, n, theScene, frame)) {
+                directColor += candidate.unshadowed;
+            }
+        }
+        return directColor;
+    }
+    for (int i = 0; i < lightSamples; i++) {
+        double u = randomDraw() * totalWeight;
+        auto picked = std::upper_bound(candidates.begin(), candidates.end() - 1, u,
+            [](double x, const LightCandidate& c) { return x < c.cumulative; });
+        raysCastByThread++;
+        if (!picked->light->pointIsInAShadow(p, n, theScene, frame)) {
+            directColor += picked->unshadowed * (totalWeight / (lightSamples * picked->weight));
+        }
+    }
+    return directColor;
+}
+
+
+/**
+ * @fn	void RayTracer::raytraceWavefrontRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top, const IScene& theScene, int n) const
+ * @brief	Raytraces the pixels in [left, right) x [bottom, top) breadth-first.
+ * 			Instead of following each pixel's tree of reflection and refraction
+ * 			rays to the bottom before starting the next pixel, all rays of one
+ * 			recursion level are queued and pushed through the same stages
+ * 			together: extend (find the closest hits), shade (which spawns the
+ * 			next wave) and shadow (light the hits). Each ray carries the weight
+ * 			that traceIndividualRay would multiply its color by, so the colors
+ * 			simply add up per pixel. Secondary waves are sorted by
+ * 			RayQueue::sortCoherently before they are intersected, which keeps the
+ * 			BVH traversal of consecutive rays (and packets) coherent.
+ * @param [in,out]	frameBuffer	Framebuffer.
+ * @param 		  	left	   	First column.
+ * @param 		  	bottom	   	First row.
+ * @param 		  	right	   	One past the last column.
+ * @param 		  	top		   	One past the last row.
+ * @param 		  	theScene   	The scene.
+ * @param 		  	n		   	Antialiasing level.
+ */
+
+void RayTracer::raytraceWavefrontRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top,
+    const IScene& theScene, int n) const {
+    const int width = right - left;
+    const int m = n > 1 ? theScene.camera->getAAGridSize(n) : 1;
+    vector<color> pixelColors(width * (top - bottom), black);
+
+    RayQueue rays, nextRays;
+    const color sampleWeight(1.0 / (m * m));
+    for (int y = bottom; y < top; ++y) {
+        for (int x = left; x < right; ++x) {
+            int pixel = (y - bottom) * width + (x - left);
+            for (int i = 0; i < m; ++i) {
+                for (int j = 0; j < m; ++j) {
+                    Ray ray = m > 1 ? theScene.camera->getAARay(x, y, i, j, m) : theScene.camera->getRay(x, y);
+                    rays.add(ray.origin, ray.dir, sampleWeight, pixel, initialRecursionDepth, primaryConeWidth);
+                }
+            }
+        }
+    }
+
+    vector<OpaqueHitRecord> hits;
+    vector<int> litHits;
+    vector<color> litWeights;
+    for (bool primary = true; rays.size() > 0; primary = false) {
+        if (!primary) {
+            rays.sortCoherently();
+        }
+        extendWave(rays, theScene, hits);
+        nextRays.clear();
+        shadeWave(rays, hits, pixelColors, litHits, litWeights, nextRays);
+        illuminateWave(rays, hits, litHits, litWeights, theScene, pixelColors);
+        std::swap(rays, nextRays);
+    }
+
+    for (int y = bottom; y < top; ++y) {
+        for (int x = left; x < right; ++x) {
+            frameBuffer.setColor(x, y, pixelColors[(y - bottom) * width + (x - left)]);
+            if (m == 1) {
+                frameBuffer.showAxes(x, y, theScene.camera->getRay(x, y), 0.25);
+            }
+        }
+    }
+}
+
+/**
+ * @fn	void RayTracer::extendWave(const RayQueue& rays, const IScene& theScene, vector<OpaqueHitRecord>& hits) const
+ * @brief	Finds the closest hit of every ray in a wave, PACKET_SIZE rays at a time
+ * 			when packets are enabled.
+ * @param 		  	rays		The wave.
+ * @param 		  	theScene	The scene.
+ * @param [out]		hits		Closest hit of each ray. t == FLT_MAX ==> nothing was hit.
+ */
+
+void RayTracer::extendWave(const RayQueue& rays, const IScene& theScene, vector<OpaqueHitRecord>& hits) const {
+    const int count = rays.size();
+    hits.resize(count);
+    raysCastByThread += count;
+    int i = 0;
+    if (usePackets) {
+        for (; i + PACKET_SIZE <= count; i += PACKET_SIZE) {
+            Ray packetRays[PACKET_SIZE] = { rays.ray(i), rays.ray(i + 1), rays.ray(i + 2), rays.ray(i + 3) };
+            RayPacket packet(packetRays, PACKET_SIZE);
+            theScene.findClosestIntersections(packet, &hits[i]);
+        }
+    }
+    for (; i < count; i++) {
+        hits[i].t = FLT_MAX;
+        theScene.findClosestIntersection(rays.ray(i), hits[i]);
+    }
+}
+
+/**
+ * @fn	void RayTracer::shadeWave(const RayQueue& rays, vector<OpaqueHitRecord>& hits, vector<color>& pixelColors, vector<int>& litHits, vector<color>& litWeights, RayQueue& nextRays) const
+ * @brief	Shades a whole wave, except that nothing is traced: misses add the
+ * 			background to their pixel, hits that need direct lighting are listed
+ * 			for illuminateWave, and the rays scatter spawns are queued for the
+ * 			next wave.
+ * @param 		  	rays	   	The wave.
+ * @param [in,out]	hits	   	Closest hit of each ray; textures are resolved into the materials.
+ * @param [in,out]	pixelColors	Accumulated color of each pixel.
+ * @param [out]		litHits	   	Hits that receive direct light.
+ * @param [out]		litWeights 	Weight of that light, per entry of litHits.
+ * @param [in,out]	nextRays   	The next wave.
+ */
+
+void RayTracer::shadeWave(const RayQueue& rays, vector<OpaqueHitRecord>& hits, vector<color>& pixelColors,
+    vector<int>& litHits, vector<color>& litWeights, RayQueue& nextRays) const {
+    litHits.clear();
+    litWeights.clear();
+    for (int i = 0; i < rays.size(); i++) {
+        OpaqueHitRecord& theHit = hits[i];
+        const color weight = rays.weight(i);
+        const int pixel = rays.pixel[i];
+        const int recursionLevel = rays.level[i];
+        if (theHit.t == FLT_MAX) {
+            pixelColors[pixel] += weight * ((recursionLevel == initialRecursionDepth) ? defaultColor : defaultColor * 0.1);
+            continue;
+        }
+
+        const dvec3 dir(rays.dx[i], rays.dy[i], rays.dz[i]);
+        color directWeight = scatter(dir, theHit, recursionLevel, weight, rays.cone[i],
+            [&](const dvec3& origin, const dvec3& dir, const color& w, int level, double cone) {
+                nextRays.add(origin, dir, w, pixel, level, cone);
+            });
+        if (directWeight != black) {
+            litHits.push_back(i);
+            litWeights.push_back(directWeight);
+        }
+    }
+}
+
+/**
+ * @fn	void RayTracer::illuminateWave(const RayQueue& rays, const vector<OpaqueHitRecord>& hits, const vector<int>& litHits, const vector<color>& litWeights, const IScene& theScene, vector<color>& pixelColors) const
+ * @brief	Casts the shadow feelers of a wave and adds the direct light to the
+ * 			pixels. Each hit is lit by directLight, exactly as traceIndividualRay
+ * 			lights it: only the lights the scene's light tree finds for the hit
+ * 			are tested, and lightSamples applies.
+ * @param 		  	rays	   	The wave.
+ * @param 		  	hits	   	Closest hit of each ray.
+ * @param 		  	litHits	   	Hits that receive direct light.
+ * @param 		  	litWeights 	Weight of that light, per entry of litHits.
+ * @param 		  	theScene   	The scene.
+ * @param [in,out]	pixelColors	Accumulated color of each pixel.
+ */
+
+void RayTracer::illuminateWave(const RayQueue& rays, const vector<OpaqueHitRecord>& hits, const vector<int>& litHits,
+    const vector<color>& litWeights, const IScene& theScene, vector<color>& pixelColors) const {
+    for (size_t k = 0; k < litHits.size(); k++) {
+        pixelColors[rays.pixel[litHits[k]]] += litWeights[k] * directLight(hits[litHits[k]], theScene);
+    }
+}
@@ -9,10 +9,15 @@
 
 #pragma once
 
+#include <memory>
+#include <atomic>
+#include <functional>
 #include "utilities.h"
 #include "framebuffer.h"
 #include "camera.h"
 #include "iscene.h"
+#include "threadpool.h"
+#include "rayqueue.h"
 
  /**
   * @struct	RayTracer
@@ -21,11 +26,58 @@
 
 struct RayTracer {
 	color defaultColor;			//!< the color to use if no intersection is present.
+	int tileSize = 0;			//!< width/height of a tile in pixels. 0 ==> serial, untiled rendering.
+	int numThreads = 0;			//!< threads used for tiled rendering. < 1 ==> one per core.
+	bool usePackets = true;		//!< trace primary rays in SIMD packets when not antialiasing.
+	double aaThreshold = 0.0;	//!< adaptive AA: refine a pixel when its corner samples differ by more than this. 0 ==> always n x n.
+	bool useWavefront = false;	//!< trace each tile breadth-first, one wave of rays at a time. Ignores aaThreshold.
+	double minRayWeight = 1.0 / 512;	//!< rays whose weight (in every channel) is at most this are not traced.
+	bool russianRoulette = false;	//!< dielectrics continue along one randomly chosen branch instead of both.
+	bool singlePrecision = false;	//!< search the scene in float; hits are still resolved in double.
+	TEXTURE_FILTER textureFilter = TRILINEAR_FILTER;	//!< how textures are sampled; the mip level follows the ray cones.
+	double lightCutoff = 0.0;	//!< attenuated lights reach as far as their direct light exceeds this. 0 ==> everywhere.
+	int lightSamples = 0;		//!< > 0 ==> shadow test this many lights per hit, picked by their unshadowed light. 0 ==> all.
 	RayTracer(const color& defaultColor);
+	static const int NUM_PASSES = 4;	//!< progressive passes: every 8th, 4th, 2nd, then every pixel.
 	void raytraceScene(FrameBuffer& frameBuffer, int depth,
-		const IScene& theScene, int n = 1);
+		IScene& theScene, int n = 1);
+	void raytracePass(FrameBuffer& frameBuffer, int depth,
+		IScene& theScene, int pass, int n = 1);
+	void setTiling(int tileSize, int numThreads = 0);
+	size_t getNumRaysTraced() const { return raysTraced; }
+	color traceRayStack(RayStack& stack, const IScene& theScene) const;
 protected:
 	color traceIndividualRay(const Ray& ray, const IScene& theScene, int recursionLevel) const;
+	color shadeHit(const Ray& ray, OpaqueHitRecord& theHit, const IScene& theScene, int recursionLevel) const;
+	color shadeHit(const Ray& ray, OpaqueHitRecord& theHit, const IScene& theScene, int recursionLevel,
+		const color& weight, double coneWidth, RayStack& stack) const;
+	template <class Spawn>
+	color scatter(const dvec3& dir, OpaqueHitRecord& theHit, int recursionLevel, const color& weight,
+		double coneWidth, Spawn spawn) const;
+	double textureLOD(const dvec3& dir, const OpaqueHitRecord& theHit, double footprint) const;
+	color directLight(const OpaqueHitRecord& theHit, const IScene& theScene) const;
+	void setupRayCones(const RaytracingCamera& camera);
+	color tracePrimaryRay(const Ray& ray, const IScene& theScene, const VisibleIShape*& object) const;
+	void raytracePixel(FrameBuffer& frameBuffer, int x, int y, const IScene& theScene, int n) const;
+	color raytraceAdaptivePixel(int x, int y, const IScene& theScene, int m) const;
+	void forEachTile(const FrameBuffer& frameBuffer,
+		const std::function<void(int left, int bottom, int right, int top)>& renderRect);
+	void raytraceSparseRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top,
+		const IScene& theScene, int stride) const;
+	void raytraceRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top,
+		const IScene& theScene, int n) const;
+	void raytraceQuad(FrameBuffer& frameBuffer, int x, int y, int right, int top, const IScene& theScene) const;
+	void raytraceWavefrontRect(FrameBuffer& frameBuffer, int left, int bottom, int right, int top,
+		const IScene& theScene, int n) const;
+	void extendWave(const RayQueue& rays, const IScene& theScene, vector<OpaqueHitRecord>& hits) const;
+	void shadeWave(const RayQueue& rays, vector<OpaqueHitRecord>& hits, vector<color>& pixelColors,
+		vector<int>& litHits, vector<color>& litWeights, RayQueue& nextRays) const;
+	void illuminateWave(const RayQueue& rays, const vector<OpaqueHitRecord>& hits, const vector<int>& litHits,
+		const vector<color>& litWeights, const IScene& theScene, vector<color>& pixelColors) const;
 
 	int initialRecursionDepth = 0;
+	double primaryConeWidth = 0.0;		//!< width of a camera ray's cone at its origin (0 for a pinhole).
+	double coneSpread = 0.0;			//!< how fast ray cones widen: the angle one pixel subtends.
+	std::unique_ptr<ThreadPool> pool;	//!< created on the first tiled frame; reused afterwards.
+	mutable std::atomic<size_t> raysTraced{ 0 };	//!< rays (including shadow feelers) cast in the last frame.
 };
\ No newline at end of file
@@ -0,0 +1,535 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+// Headless render driver. Renders one frame without opening a window, writes
+// it to a PPM (or PFM) file and reports how long it took. Build every translation
+// unit with CONSOLE_ONLY defined so nothing touches OpenGL/GLUT. The flags are
+// listed by usage(), which an unknown flag prints.
+//
+// With -frames, the scene is animated instead: the transparent plane sweeps
+// through it as in fullraytrace, the copper sphere circles the y axis, and frame
+// f is written to <output name>_<f>.ppm. Shard i of n renders every nth frame,
+// starting at frame i, so that several processes can split the work.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include "defs.h"
+#include "io.h"
+#include "ishape.h"
+#include "trianglemesh.h"
+#include "framebuffer.h"
+#include "raytracer.h"
+#include "iscene.h"
+#include "light.h"
+#include "image.h"
+#include "camera.h"
+#include "eshape.h"
+#include "vertexops.h"
+#include "frameexport.h"
+#include "animation.h"
+
+/**
+ * @struct	DriverOptions
+ * @brief	Settings taken from the command line.
+ */
+
+struct DriverOptions {
+	string mode = "raytrace";		//!< "raytrace" or "raster"
+	int width = WINDOW_WIDTH;		//!< image width
+	int height = WINDOW_HEIGHT;		//!< image height
+	int antiAliasing = 1;			//!< n ==> n x n rays per pixel
+	double aaThreshold = 0.0;		//!< > 0 ==> adaptive AA; n x n becomes the cap
+	int depth = 2;					//!< recursion depth for reflection/refraction
+	int numThreads = 0;				//!< 0 ==> one per core
+	int tileSize = 16;				//!< 0 ==> serial, untiled rendering
+	bool usePackets = true;			//!< trace primary rays in SIMD packets
+	bool progressive = false;		//!< render in coarse-to-fine passes and time the first one
+	bool wavefront = false;			//!< trace breadth-first, one wave of rays at a time
+	double minRayWeight = 1.0 / 512;	//!< rays weighing no more than this are not traced
+	bool russianRoulette = false;	//!< dielectrics follow one random branch
+	bool singlePrecision = false;	//!< search the scene in float
+	TEXTURE_FILTER textureFilter = TRILINEAR_FILTER;	//!< how textures are sampled
+	TEXEL_FORMAT texelFormat = RGB8_TEXELS;			//!< how textures are stored
+	bool tiledFrameBuffer = false;	//!< tiled framebuffer layout with lazy clears
+	bool accumulate = false;		//!< keep the framebuffer's colors as floats
+	string meshFile;				//!< OBJ model to add to the ray traced scene, if any
+	string outputFile = "render.ppm";
+	int numFrames = 0;				//!< > 0 ==> render an animation of this many frames
+	int shardIndex = 0;				//!< which of numShards shares of the frames to render
+	int numShards = 1;
+	int framesInFlight = 1;			//!< frames traced at once, each with its own scene
+	int numExtraLights = 0;			//!< attenuated lights added to the scene
+	double lightCutoff = 0.0;		//!< direct light below this is negligible; 0 ==> exact
+	int lightSamples = 0;			//!< > 0 ==> shadow test this many lights per hit
+};
+
+static void usage(const char* program) {
+	std::cerr << "Usage: " << program << " [-mode raytrace|raster] [-w width] [-h height]" << endl
+		<< "\t[-aa n] [-adaptive threshold] [-depth n] [-threads n] [-tile n] [-packets 0|1]" << endl
+		<< "\t[-progressive 0|1] [-wavefront 0|1] [-cutoff weight] [-roulette 0|1]" << endl
+		<< "\t[-float 0|1] [-filter nearest|bilinear|trilinear] [-texels double|rgb8|rgba8|srgb8|half]" << endl
+		<< "\t[-fb linear|tiled] [-accum 0|1] [-mesh file.obj] [-o file.ppm|file.pfm]" << endl
+		<< "\t[-frames n] [-shard i/n] [-inflight n] [-lights n] [-lightcutoff w] [-lightsamples n]" << endl;
+}
+
+/**
+ * @fn	static bool parseOptions(int argc, char* argv[], DriverOptions& opts)
+ * @brief	Parses the command line.
+ * @param 		  	argc	Number of arguments.
+ * @param 		  	argv	The arguments.
+ * @param [out]		opts	The parsed options.
+ * @return	True iff the command line was valid.
+ */
+
+static bool parseOptions(int argc, char* argv[], DriverOptions& opts) {
+	for (int i = 1; i < argc; i++) {
+		string flag = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << flag << endl;
+			return false;
+		}
+		string value = argv[++i];
+		if (flag == "-mode") {
+			opts.mode = value;
+		} else if (flag == "-w") {
+			opts.width = atoi(value.c_str());
+		} else if (flag == "-h") {
+			opts.height = atoi(value.c_str());
+		} else if (flag == "-aa") {
+			opts.antiAliasing = atoi(value.c_str());
+		} else if (flag == "-adaptive") {
+			opts.aaThreshold = atof(value.c_str());
+		} else if (flag == "-depth") {
+			opts.depth = atoi(value.c_str());
+		} else if (flag == "-threads") {
+			opts.numThreads = atoi(value.c_str());
+		} else if (flag == "-tile") {
+			opts.tileSize = atoi(value.c_str());
+		} else if (flag == "-packets") {
+			opts.usePackets = atoi(value.c_str()) != 0;
+		} else if (flag == "-progressive") {
+			opts.progressive = atoi(value.c_str()) != 0;
+		} else if (flag == "-wavefront") {
+			opts.wavefront = atoi(value.c_str()) != 0;
+		} else if (flag == "-cutoff") {
+			opts.minRayWeight = atof(value.c_str());
+		} else if (flag == "-roulette") {
+			opts.russianRoulette = atoi(value.c_str()) != 0;
+		} else if (flag == "-float") {
+			opts.singlePrecision = atoi(value.c_str()) != 0;
+		} else if (flag == "-filter") {
+			if (value == "nearest") {
+				opts.textureFilter = NEAREST_FILTER;
+			} else if (value == "bilinear") {
+				opts.textureFilter = BILINEAR_FILTER;
+			} else if (value == "trilinear") {
+				opts.textureFilter = TRILINEAR_FILTER;
+			} else {
+				std::cerr << "Unknown filter " << value << endl;
+				return false;
+			}
+		} else if (flag == "-texels") {
+			if (value == "double") {
+				opts.texelFormat = DOUBLE_TEXELS;
+			} else if (value == "rgb8") {
+				opts.texelFormat = RGB8_TEXELS;
+			} else if (value == "rgba8") {
+				opts.texelFormat = RGBA8_TEXELS;
+			} else if (value == "srgb8") {
+				opts.texelFormat = SRGB8_TEXELS;
+			} else if (value == "half") {
+				opts.texelFormat = HALF_TEXELS;
+			} else {
+				std::cerr << "Unknown texel format " << value << endl;
+				return false;
+			}
+		} else if (flag == "-fb") {
+			if (value != "linear" && value != "tiled") {
+				std::cerr << "Unknown framebuffer layout " << value << endl;
+				return false;
+			}
+			opts.tiledFrameBuffer = value == "tiled";
+		} else if (flag == "-accum") {
+			opts.accumulate = atoi(value.c_str()) != 0;
+		} else if (flag == "-mesh") {
+			opts.meshFile = value;
+		} else if (flag == "-o") {
+			opts.outputFile = value;
+		} else if (flag == "-frames") {
+			opts.numFrames = atoi(value.c_str());
+		} else if (flag == "-shard") {
+			if (sscanf(value.c_str(), "%d/%d", &opts.shardIndex, &opts.numShards) != 2 ||
+				opts.numShards < 1 || opts.shardIndex < 0 || opts.shardIndex >= opts.numShards) {
+				std::cerr << "Invalid shard " << value << endl;
+				return false;
+			}
+		} else if (flag == "-inflight") {
+			opts.framesInFlight = atoi(value.c_str());
+		} else if (flag == "-lights") {
+			opts.numExtraLights = atoi(value.c_str());
+		} else if (flag == "-lightcutoff") {
+			opts.lightCutoff = atof(value.c_str());
+		} else if (flag == "-lightsamples") {
+			opts.lightSamples = atoi(value.c_str());
+		} else {
+			std::cerr << "Unknown option " << flag << endl;
+			return false;
+		}
+	}
+	if (opts.mode != "raytrace" && opts.mode != "raster") {
+		std::cerr << "Unknown mode " << opts.mode << endl;
+		return false;
+	}
+	if (opts.width < 1 || opts.height < 1 || opts.antiAliasing < 1 || opts.depth < 0) {
+		std::cerr << "Invalid image size, antialiasing level or depth" << endl;
+		return false;
+	}
+	if (opts.numFrames > 0 && opts.mode != "raytrace") {
+		std::cerr << "Only ray traced animations are supported" << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @fn	static Image* loadTexture(const string& filename, TEXEL_FORMAT format)
+ * @brief	Loads a texture, or returns nullptr if the file could not be read so
+ * 			that the object is rendered untextured.
+ * @param	filename	The PPM file.
+ * @param	format  	How the texture stores its texels.
+ * @return	The texture, or nullptr.
+ */
+
+static Image* loadTexture(const string& filename, TEXEL_FORMAT format) {
+	Image* im = new Image(filename, format);
+	if (im->W == 0 || im->H == 0) {
+		std::cerr << "Skipping texture " << filename << endl;
+		delete im;
+		return nullptr;
+	}
+	return im;
+}
+
+/**
+ * @struct	AnimatedShapes
+ * @brief	The shapes of a benchmark scene that move when it is animated.
+ */
+
+struct AnimatedShapes {
+	IPlane* clearPlane = nullptr;		//!< the transparent plane
+	ISphere* copperSphere = nullptr;	//!< the small copper sphere
+};
+
+/**
+ * @fn	static AnimatedShapes buildRaytraceScene(IScene& scene, TEXEL_FORMAT texelFormat)
+ * @brief	The benchmark scene. Same objects, materials and lights as fullraytrace.
+ * @param [in,out]	scene	   	The scene to fill.
+ * @param 		  	texelFormat	How the textures store their texels.
+ * @return	The shapes animateBenchmarkScene moves; the scene owns them.
+ */
+
+static AnimatedShapes buildRaytraceScene(IScene& scene, TEXEL_FORMAT texelFormat) {
+	AnimatedShapes animated;
+	Image* flag = loadTexture("usflag.ppm", texelFormat);
+	Image* earth = loadTexture("earth.ppm", texelFormat);
+
+	scene.addOpaqueObject(new VisibleIShape(new IPlane(dvec3(0.0, -2.0, 0.0), dvec3(0.0, -1.0, 0.0)), tin));
+	animated.clearPlane = new IPlane(dvec3(0.0, 0.0, 0.0), dvec3(0.0, 0.0, 1.0));
+	scene.addOpaqueObject(new VisibleIShape(animated.clearPlane, glassDielectric));
+
+	scene.addOpaqueObject(new VisibleIShape(new ISphere(dvec3(0.0, 0.0, 0.0), 4.0), silver, earth));
+	animated.copperSphere = new ISphere(dvec3(13.0, 2.0, 2.0), 1.0);
+	scene.addOpaqueObject(new VisibleIShape(animated.copperSphere, copper));
+	scene.addOpaqueObject(new VisibleIShape(new IGeometricSphere(dvec3(-20.0, 2.0, -8.0), 4.0), yellowPlastic));
+	scene.addOpaqueObject(new VisibleIShape(new IEllipsoid(dvec3(-2.0, 3.0, 7.0), dvec3(1.0, 1.0, 2.5)), copper));
+
+	scene.addOpaqueObject(new VisibleIShape(new IClosedCylinderY(dvec3(7.0, 5.0, -4.0), 2.0, 7.0), gold));
+	scene.addOpaqueObject(new VisibleIShape(new ICylinderY(dvec3(15.0, 0.0, -4.0), 1.5, 3.0), red, flag));
+
+	scene.addOpaqueObject(new VisibleIShape(new IClosedConeY(dvec3(12, 2, -10), 4.0, 4.0), greenPlastic));
+
+	scene.addOpaqueObject(new VisibleIShape(new IDisk(dvec3(3.0, 0.0, 14.0), dvec3(1.0, 0.0, 0.0), 3.0), redPlastic));
+	scene.addOpaqueObject(new VisibleIShape(new ITriangle(dvec3(-6, 0, 15), dvec3(-8, 8, 11), dvec3(-10, 0, 6)), greenRubber));
+
+	scene.addLight(new PositionalLight(dvec3(23, 16, 9), white));
+	scene.addLight(new DirectionalLight(dvec3(-1, -1, -0.5), white * 0.25));
+	return animated;
+}
+
+/**
+ * @fn	static void addLightingRig(IScene& scene, int numLights)
+ * @brief	Hangs attenuated, colored lights over the scene, at random but always
+ * 			the same places; every fourth is a spot light pointing down. Together
+ * 			they are about as bright as sixteen lights.
+ * @param [in,out]	scene	 	The scene.
+ * @param 		  	numLights	Number of lights to add.
+ */
+
+static void addLightingRig(IScene& scene, int numLights) {
+	std::minstd_rand generator(386);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const LightATParams falloff(1.0, 0.5, 0.5);
+	const double brightness = std::min(16.0 / numLights, 1.0);
+	for (int i = 0; i < numLights; i++) {
+		dvec3 pos(-30.0 + 60.0 * unit(generator), 6.0 * unit(generator), -30.0 + 60.0 * unit(generator));
+		color tint = brightness * glm::mix(white, color(unit(generator), unit(generator), unit(generator)), 0.5);
+		PositionalLight* light;
+		if (i % 4 == 3) {
+			light = new SpotLight(pos, -Y_AXIS, glm::radians(60.0), tint);
+			light->atParams.constant = falloff.constant;
+			light->atParams.linear = falloff.linear;
+			light->atParams.quadratic = falloff.quadratic;
+		} else {
+			light = new PositionalLight(pos, falloff, tint);
+		}
+		light->attenuationIsTurnedOn = true;
+		scene.addLight(light);
+	}
+}
+
+/**
+ * @fn	static AnimatedShapes buildBenchmarkScene(const DriverOptions& opts, IScene& scene)
+ * @brief	The benchmark scene, with the mesh (if any) and the camera.
+ * @param 		  	opts 	The options.
+ * @param [in,out]	scene	The scene to fill.
+ * @return	The shapes animateBenchmarkScene moves.
+ */
+
+static AnimatedShapes buildBenchmarkScene(const DriverOptions& opts, IScene& scene) {
+	AnimatedShapes animated = buildRaytraceScene(scene, opts.texelFormat);
+	addLightingRig(scene, opts.numExtraLights);
+	if (!opts.meshFile.empty()) {
+		// Scaled and placed for mario.obj, which is about 250 units tall.
+		ITriangleMesh* mesh = new ITriangleMesh(opts.meshFile, T(6.0, -2.0, 8.0) * S(0.03));
+		cout << "Mesh: " << mesh->getNumTriangles() << " triangles" << endl;
+		scene.addOpaqueObject(new VisibleIShape(mesh, redPlastic));
+	}
+	scene.camera = new PerspectiveCamera(dvec3(20, 10, 20), dvec3(0, 0, 0), Y_AXIS,
+										glm::radians(45.0), opts.width, opts.height);
+	return animated;
+}
+
+/**
+ * @fn	static void configureRayTracer(const DriverOptions& opts, int numThreads, RayTracer& rayTrace)
+ * @brief	Applies the ray tracing options.
+ * @param 		  	opts	  	The options.
+ * @param 		  	numThreads	Threads to trace each frame with; 0 ==> one per core.
+ * @param [in,out]	rayTrace  	The ray tracer.
+ */
+
+static void configureRayTracer(const DriverOptions& opts, int numThreads, RayTracer& rayTrace) {
+	rayTrace.defaultColor = paleGreen;
+	rayTrace.setTiling(opts.tileSize, numThreads);
+	rayTrace.usePackets = opts.usePackets;
+	rayTrace.aaThreshold = opts.aaThreshold;
+	rayTrace.useWavefront = opts.wavefront;
+	rayTrace.minRayWeight = opts.minRayWeight;
+	rayTrace.russianRoulette = opts.russianRoulette;
+	rayTrace.singlePrecision = opts.singlePrecision;
+	rayTrace.textureFilter = opts.textureFilter;
+	rayTrace.lightCutoff = opts.lightCutoff;
+	rayTrace.lightSamples = opts.lightSamples;
+}
+
+/**
+ * @fn	static double runRaytrace(const DriverOptions& opts, FrameBuffer& frameBuffer, size_t& numRays)
+ * @brief	Ray traces the benchmark scene.
+ * @param 		  	opts	   	The options.
+ * @param [in,out]	frameBuffer	The framebuffer to render into.
+ * @param [out]		numRays	   	Number of rays cast.
+ * @return	Wall-clock time of the render, in seconds.
+ */
+
+static double runRaytrace(const DriverOptions& opts, FrameBuffer& frameBuffer, size_t& numRays) {
+	IScene scene;
+	buildBenchmarkScene(opts, scene);
+
+	RayTracer rayTrace(paleGreen);
+	configureRayTracer(opts, opts.numThreads, rayTrace);
+
+	auto start = std::chrono::steady_clock::now();
+	if (opts.progressive) {
+		for (int pass = 0; pass < RayTracer::NUM_PASSES; pass++) {
+			rayTrace.raytracePass(frameBuffer, opts.depth, scene, pass, opts.antiAliasing);
+			if (pass == 0) {
+				double firstPass = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				cout << "First pass: " << firstPass << " sec." << endl;
+			}
+		}
+	} else {
+		rayTrace.raytraceScene(frameBuffer, opts.depth, scene, opts.antiAliasing);
+	}
+	auto stop = std::chrono::steady_clock::now();
+
+	numRays = rayTrace.getNumRaysTraced();
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * @fn	static void animateBenchmarkScene(const AnimatedShapes& animated, double time)
+ * @brief	Poses the benchmark scene at a time in [0, 1]: the transparent plane
+ * 			sweeps from z = -10 to z = 4 (the range fullraytrace's timer bounces
+ * 			it through) and the copper sphere makes one turn about the y axis.
+ * @param	animated	The shapes, as buildBenchmarkScene returned them.
+ * @param	time		The time.
+ */
+
+static void animateBenchmarkScene(const AnimatedShapes& animated, double time) {
+	animated.clearPlane->a = dvec3(0.0, 0.0, glm::mix(-10.0, 4.0, time));
+	double angle = 2 * PI * time;
+	animated.copperSphere->center = dvec3(13.0 * std::cos(angle) + 2.0 * std::sin(angle), 2.0,
+										  2.0 * std::cos(angle) - 13.0 * std::sin(angle));
+}
+
+/**
+ * @fn	static double runAnimation(const DriverOptions& opts, int& numFramesRendered)
+ * @brief	Renders this process's share of the animated benchmark scene.
+ * @param 		  	opts			 	The options.
+ * @param [out]		numFramesRendered	Number of frames rendered.
+ * @return	Wall-clock time of the render, in seconds, including writing the frames.
+ */
+
+static double runAnimation(const DriverOptions& opts, int& numFramesRendered) {
+	int framesInFlight = std::max(opts.framesInFlight, 1);
+	int threadsPerFrame = std::max((opts.numThreads > 0 ? opts.numThreads : ThreadPool::defaultNumThreads()) / framesInFlight, 1);
+
+	// Filled as the scenes are built, one at a time, before any is traced;
+	// the workers only read it.
+	std::map<const IScene*, AnimatedShapes> animated;
+	AnimationBatch batch([&](IScene& scene) { animated[&scene] = buildBenchmarkScene(opts, scene); },
+						 [&](IScene& scene, int, double time) { animateBenchmarkScene(animated.at(&scene), time); });
+	batch.setTimeRange(0.0, 1.0, opts.numFrames);
+	batch.setShard(opts.shardIndex, opts.numShards);
+	batch.setFramesInFlight(framesInFlight);
+	batch.setTracerSetup([&](RayTracer& rayTrace) { configureRayTracer(opts, threadsPerFrame, rayTrace); });
+	batch.setFrameBufferFormat(opts.tiledFrameBuffer ? TILED_LAYOUT : LINEAR_LAYOUT, opts.accumulate);
+
+	IMAGE_FILE_FORMAT format = imageFileFormat(opts.outputFile);
+	string prefix = opts.outputFile.substr(0, opts.outputFile.rfind('.')) + "_";
+	FrameExporter exporter(framesInFlight + 1);
+	ImageSequence sequence(exporter, prefix, format);
+
+	auto start = std::chrono::steady_clock::now();
+	numFramesRendered = batch.render(opts.width, opts.height, opts.depth, opts.antiAliasing, sequence);
+	exporter.flush();
+	auto stop = std::chrono::steady_clock::now();
+
+	if (exporter.getNumFailed() > 0) {
+		numFramesRendered = -1;
+	}
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * @fn	static double runRaster(const DriverOptions& opts, FrameBuffer& frameBuffer)
+ * @brief	Renders the benchmark scene through the rasterization pipeline.
+ * @param 		  	opts	   	The options.
+ * @param [in,out]	frameBuffer	The framebuffer to render into.
+ * @return	Wall-clock time of the render, in seconds.
+ */
+
+static double runRaster(const DriverOptions& opts, FrameBuffer& frameBuffer) {
+	vector<LightSourcePtr> lights = { new PositionalLight(dvec3(0, 10, 4), white) };
+	dvec4 A(-1, -1, 0, 1);
+	dvec4 B(+1, -1, 0, 1);
+	dvec4 C(0, +1, 0, 1);
+	EShapeData board = EShape::createECheckerBoard(copper, polishedCopper, 10, 10, 10);
+	EShapeData tri1 = EShape::createETriangle(gold, A, B, C);
+	EShapeData tri2 = EShape::createETriangle(polishedCopper, A, B, C);
+	EShapeData cone = EShape::createECone(pewter, 8);
+	EShapeData coneBase = EShape::createEDisk(pewter, 8);
+	EShapeData mesh;
+	if (!opts.meshFile.empty()) {
+		mesh = EShape::createEObj(opts.meshFile);
+		cout << "Mesh: " << mesh.size() / 3 << " triangles" << endl;
+	}
+
+	PipelineMatrices pipeMats;
+	double AR = (double)opts.width / opts.height;
+	pipeMats.viewingMatrix = glm::lookAt(dvec3(0, 5, 5), dvec3(0, 0, 0), Y_AXIS);
+	pipeMats.projectionMatrix = glm::perspective(PI_3, AR, 0.5, 80.0);
+	pipeMats.viewportMatrix = VertexOps::getViewportTransformation(0, opts.width, 0, opts.height);
+
+	FragmentOps::textureFilter = opts.textureFilter;
+	VertexOps::numThreads = opts.numThreads;
+	auto start = std::chrono::steady_clock::now();
+	VertexOps::render(frameBuffer, board, lights, dmat4(), pipeMats, true);
+	VertexOps::render(frameBuffer, tri1, lights, T(0, 2, 0) * S(5, 2, 1), pipeMats, true);
+	VertexOps::render(frameBuffer, tri2, lights, T(-1, 0, 0) * Ry(-PI_3) * S(10, 3, 1), pipeMats, true);
+	VertexOps::render(frameBuffer, cone, lights, T(-3, 0, 3), pipeMats, true);
+	VertexOps::render(frameBuffer, coneBase, lights, T(-3, 0, 3) * Rx(PI / 2), pipeMats, true);
+	if (!mesh.empty()) {
+		// Scaled for mario.obj, which is about 250 units tall.
+		VertexOps::render(frameBuffer, mesh, lights, T(2, 0, 1) * S(0.01), pipeMats, true);
+	}
+	auto stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+int main(int argc, char* argv[]) {
+	DriverOptions opts;
+	if (!parseOptions(argc, argv, opts)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (opts.numFrames > 0) {
+		int numFramesRendered;
+		double seconds = runAnimation(opts, numFramesRendered);
+		if (numFramesRendered < 0) {
+			return 1;
+		}
+		cout << "Frames: " << numFramesRendered << " of " << opts.numFrames
+			<< " (shard " << opts.shardIndex << "/" << opts.numShards << ")"
+			<< "  in flight: " << std::max(opts.framesInFlight, 1) << endl;
+		cout << "Render time: " << seconds << " sec.  (" << seconds / std::max(numFramesRendered, 1)
+			<< " sec./frame)" << endl;
+		return 0;
+	}
+
+	FrameBuffer frameBuffer(opts.width, opts.height, opts.tiledFrameBuffer ? TILED_LAYOUT : LINEAR_LAYOUT);
+	frameBuffer.setAccumulation(opts.accumulate);
+	frameBuffer.setClearColor(lightGray);
+	frameBuffer.clearColorAndDepthBuffers();
+
+	double seconds;
+	size_t numRays = 0;
+	if (opts.mode == "raytrace") {
+		seconds = runRaytrace(opts, frameBuffer, numRays);
+	} else {
+		seconds = runRaster(opts, frameBuffer);
+	}
+
+	cout << "Mode: " << opts.mode << "  " << opts.width << "x" << opts.height
+		<< "  AA: " << opts.antiAliasing << (opts.aaThreshold > 0.0 ? " (adaptive)" : "")
+		<< "  depth: " << opts.depth;
+	cout << "  threads: " << (opts.numThreads > 0 ? opts.numThreads : ThreadPool::defaultNumThreads());
+	if (opts.mode == "raytrace") {
+		cout << "  tile: " << opts.tileSize << "  packets: " << (opts.usePackets ? "on" : "off");
+	}
+	cout << endl;
+	cout << "Render time: " << seconds << " sec." << endl;
+	if (numRays > 0) {
+		cout << "Rays: " << numRays << "  (" << numRays / seconds / 1.0e6 << " Mrays/sec)" << endl;
+	}
+
+	FrameExporter exporter;
+	exporter.save(frameBuffer, opts.outputFile);
+	exporter.flush();
+	if (exporter.getNumFailed() > 0) {
+		return 1;
+	}
+	cout << "Wrote " << opts.outputFile << endl;
+	return 0;
+}
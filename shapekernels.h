@@ -0,0 +1,477 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+// Ray/shape intersection tests written against plain parameters rather than
+// shape objects. The IShape classes and CompiledScene both call these, so the
+// two always agree bit for bit. Each returns the t value of the closest hit in
+// front of the ray, or FLT_MAX if there is none. The scalar tests are templated
+// on the precision (T) they compute in; CompiledSceneF runs them in float.
+
+#pragma once
+#include <algorithm>
+#include "ishape.h"
+#include "utilities.h"
+
+/**
+ * @struct	QuadricCoefficients
+ * @brief	The ten coefficients of a quadric, in any precision. Anything with
+ * 			members A through J (e.g., QuadricParameters) works where the kernels
+ * 			take a Q.
+ */
+
+template <class T>
+struct QuadricCoefficients {
+	T A, B, C, D, E, F, G, H, I, J;
+};
+
+/**
+ * @fn	template <class T> inline T planeClosestT(const glm::tvec3<T>& a, const glm::tvec3<T>& n, const RayT<T>& ray)
+ * @brief	Ray/plane test.
+ * @param	a  	A point on the plane.
+ * @param	n  	The plane's unit normal.
+ * @param	ray	The ray.
+ * @return	t of the hit, or FLT_MAX.
+ */
+
+template <class T>
+inline T planeClosestT(const glm::tvec3<T>& a, const glm::tvec3<T>& n, const RayT<T>& ray) {
+	T denom = glm::dot(ray.dir, n);
+	if (glm::abs(denom) < EPSILON) {
+		return FLT_MAX;
+	}
+	T t = glm::dot(a - ray.origin, n) / denom;
+	return t < EPSILON ? FLT_MAX : t;
+}
+
+/**
+ * @fn	template <class T> inline T diskClosestT(const glm::tvec3<T>& center, const glm::tvec3<T>& n, T radius, const RayT<T>& ray)
+ * @brief	Ray/disk test.
+ * @param	center	The disk's center.
+ * @param	n	  	The disk's unit normal.
+ * @param	radius	The disk's radius.
+ * @param	ray   	The ray.
+ * @return	t of the hit, or FLT_MAX.
+ */
+
+template <class T>
+inline T diskClosestT(const glm::tvec3<T>& center, const glm::tvec3<T>& n, T radius, const RayT<T>& ray) {
+	T denom = glm::dot(ray.dir, n);
+	if (glm::abs(denom) > EPSILON) {
+		T t = glm::dot(center - ray.origin, n) / denom;
+		if (t > EPSILON && glm::distance(ray.origin + t * ray.dir, center) <= radius) {
+			return t;
+		}
+	}
+	return FLT_MAX;
+}
+
+/**
+ * @fn	template <int FORM, class Q, class T> inline int quadricRoots(const Q& q, const glm::tvec3<T>& center, const RayT<T>& ray, T roots[2])
+ * @brief	Solves for where a ray meets a quadric surface. Spheres use the
+ * 			closed form with the factors of 2 cancelled.
+ * @param 		  	q	  	The quadric's coefficients; their form must be at least as sparse as FORM.
+ * @param 		  	center	The quadric's center.
+ * @param 		  	ray   	The ray.
+ * @param [out]		roots 	The t values, in ascending order.
+ * @return	Number of roots (0, 1 or 2).
+ */
+
+template <int FORM, class Q, class T>
+inline int quadricRoots(const Q& q, const glm::tvec3<T>& center, const RayT<T>& ray, T roots[2]) {
+	glm::tvec3<T> Ro = ray.origin - center;
+	const glm::tvec3<T>& Rd = ray.dir;
+	if (FORM == SPHERICAL_QUADRIC) {
+		T a = q.A * glm::dot(Rd, Rd);
+		T halfB = q.A * glm::dot(Ro, Rd);
+		T c = q.A * glm::dot(Ro, Ro) + q.J;
+		T discriminant = halfB * halfB - a * c;
+		if (!(discriminant >= 0) || a == 0) {
+			return 0;
+		}
+		if (discriminant == 0) {
+			roots[0] = -halfB / a;
+			return 1;
+		}
+		// Cancellation-free, as in quadratic().
+		T root = std::sqrt(discriminant);
+		T qRoot = -(halfB < 0 ? halfB - root : halfB + root);
+		roots[0] = qRoot / a;
+		roots[1] = c / qRoot;
+		if (roots[0] > roots[1]) {
+			std::swap(roots[0], roots[1]);
+		}
+		return 2;
+	}
+
+	T Aq = q.A * (Rd.x * Rd.x) +
+		q.B * (Rd.y * Rd.y) +
+		q.C * (Rd.z * Rd.z);
+	T Bq = (T(2) * q.A) * Ro.x * Rd.x +
+		(T(2) * q.B) * Ro.y * Rd.y +
+		(T(2) * q.C) * Ro.z * Rd.z;
+	T Cq = q.A * (Ro.x * Ro.x) +
+		q.B * (Ro.y * Ro.y) +
+		q.C * (Ro.z * Ro.z);
+	if (FORM == GENERAL_QUADRIC) {
+		Aq += q.D * (Rd.x * Rd.y) +
+			q.E * (Rd.x * Rd.z) +
+			q.F * (Rd.y * Rd.z);
+		Bq += q.D * (Ro.x * Rd.y + Ro.y * Rd.x) +
+			q.E * (Ro.x * Rd.z + Ro.z * Rd.x) +
+			q.F * (Ro.y * Rd.z + Ro.z * Rd.y) +
+			q.G * Rd.x + q.H * Rd.y + q.I * Rd.z;
+		Cq += q.D * (Ro.x * Ro.y) +
+			q.E * (Ro.x * Ro.z) +
+			q.F * (Ro.y * Ro.z) +
+			q.G * Ro.x +
+			q.H * Ro.y +
+			q.I * Ro.z;
+	}
+	Cq += q.J;
+	return quadratic(Aq, Bq, Cq, roots);
+}
+
+/**
+ * @fn	template <int FORM> inline dvec3 quadricNormal(const QuadricParameters& q, const dvec3& center, const dvec3& P)
+ * @brief	Unit normal (the normalized gradient) of a quadric at a point.
+ * @param	q	  	The quadric's parameters, which must fit FORM.
+ * @param	center	The quadric's center.
+ * @param	P	  	A point on the surface.
+ * @return	The normal.
+ */
+
+template <int FORM>
+inline dvec3 quadricNormal(const QuadricParameters& q, const dvec3& center, const dvec3& P) {
+	dvec3 pt = P - center;
+	if (FORM == SPHERICAL_QUADRIC) {
+		return glm::normalize(q.A > 0 ? pt : -pt);
+	}
+	dvec3 normal((2.0 * q.A) * pt.x, (2.0 * q.B) * pt.y, (2.0 * q.C) * pt.z);
+	if (FORM == GENERAL_QUADRIC) {
+		normal += dvec3(q.D * pt.y + q.E * pt.z + q.G,
+						q.D * pt.x + q.F * pt.z + q.H,
+						q.E * pt.x + q.F * pt.y + q.I);
+	}
+	return glm::normalize(normal);
+}
+
+/**
+ * @fn	template <int FORM, class Q, class T> inline T quadricClosestT(const Q& q, const glm::tvec3<T>& center, const RayT<T>& ray)
+ * @brief	Ray/quadric test.
+ * @param	q	  	The quadric's coefficients, which must fit FORM.
+ * @param	center	The quadric's center.
+ * @param	ray   	The ray.
+ * @return	t of the hit, or FLT_MAX.
+ */
+
+template <int FORM, class Q, class T>
+inline T quadricClosestT(const Q& q, const glm::tvec3<T>& center, const RayT<T>& ray) {
+	T roots[2];
+	int numRoots = quadricRoots<FORM>(q, center, ray, roots);
+	for (int i = 0; i < numRoots; i++) {
+		if (roots[i] > EPSILON) {
+			return roots[i];
+		}
+	}
+	return FLT_MAX;
+}
+
+/**
+ * @fn	template <class Q, class T> inline T cylinderYClosestT(const Q& q, const glm::tvec3<T>& center, T yLo, T yHi, const RayT<T>& ray)
+ * @brief	Ray test against a y-aligned cylinder clipped to yLo < y < yHi.
+ * @param	q	  	The cylinder's coefficients (axis aligned).
+ * @param	center	The cylinder's center.
+ * @param	yLo   	Lower clipping height (exclusive).
+ * @param	yHi   	Upper clipping height (exclusive).
+ * @param	ray   	The ray.
+ * @return	t of the hit, or FLT_MAX.
+ */
+
+template <class Q, class T>
+inline T cylinderYClosestT(const Q& q, const glm::tvec3<T>& center, T yLo, T yHi, const RayT<T>& ray) {
+	T roots[2];
+	int numRoots = quadricRoots<AXIS_ALIGNED_QUADRIC>(q, center, ray, roots);
+	for (int i = 0; i < numRoots; i++) {
+		if (roots[i] <= EPSILON) {
+			continue;
+		}
+		T y = ray.origin.y + roots[i] * ray.dir.y;
+		if (y < yHi && y > yLo) {
+			return roots[i];
+		}
+	}
+	return FLT_MAX;
+}
+
+/**
+ * @fn	template <class Q, class T> inline T coneYClosestT(const Q& q, const glm::tvec3<T>& center, T yLo, T yHi, const RayT<T>& ray)
+ * @brief	Ray test against a y-aligned cone clipped to yLo <= y <= yHi.
+ * @param	q	  	The cone's coefficients (axis aligned).
+ * @param	center	The cone's center.
+ * @param	yLo   	Lower clipping height (inclusive).
+ * @param	yHi   	Upper clipping height (inclusive).
+ * @param	ray   	The ray.
+ * @return	t of the hit, or FLT_MAX.
+ */
+
+template <class Q, class T>
+inline T coneYClosestT(const Q& q, const glm::tvec3<T>& center, T yLo, T yHi, const RayT<T>& ray) {
+	T roots[2];
+	int numRoots = quadricRoots<AXIS_ALIGNED_QUADRIC>(q, center, ray, roots);
+	for (int i = 0; i < numRoots; i++) {
+		if (roots[i] <= EPSILON) {
+			continue;
+		}
+		T y = ray.origin.y + roots[i] * ray.dir.y;
+		if (y >= yLo && y <= yHi) {
+			return roots[i];
+		}
+	}
+	return FLT_MAX;
+}
+
+/**
+ * @struct	TriangleDataT
+ * @brief	What a ray/triangle test needs, precomputed from the three vertices.
+ * 			The precomputation is always done in double; a float copy just rounds
+ * 			the results.
+ */
+
+template <class T>
+struct TriangleDataT {
+	glm::tvec3<T> a;		//!< first vertex
+	glm::tvec3<T> n;		//!< unit normal of the triangle's plane
+	glm::tvec3<T> v0, v1;	//!< b - a and c - a
+	T d00, d01, d11;		//!< dot products of v0 and v1
+	T denom;				//!< d00 * d11 - d01 * d01
+	TriangleDataT() {}
+	TriangleDataT(const dvec3& a, const dvec3& b, const dvec3& c) {
+		dvec3 e0 = b - a;
+		dvec3 e1 = c - a;
+		double dd00 = glm::dot(e0, e0);
+		double dd01 = glm::dot(e0, e1);
+		double dd11 = glm::dot(e1, e1);
+		this->a = glm::tvec3<T>(a);
+		n = glm::tvec3<T>(glm::normalize(normalFrom3Points(a, b, c)));
+		v0 = glm::tvec3<T>(e0);
+		v1 = glm::tvec3<T>(e1);
+		d00 = (T)dd00;
+		d01 = (T)dd01;
+		d11 = (T)dd11;
+		denom = (T)(dd00 * dd11 - dd01 * dd01);
+	}
+};
+
+typedef TriangleDataT<double> TriangleData;
+
+/**
+ * @fn	template <class T> inline T triangleClosestT(const TriangleDataT<T>& tri, const RayT<T>& ray)
+ * @brief	Ray/triangle test: intersects the triangle's plane, then checks the
+ * 			barycentric coordinates of the intercept point.
+ * @param	tri	The triangle.
+ * @param	ray	The ray.
+ * @return	t of the hit, or FLT_MAX.
+ */
+
+template <class T>
+inline T triangleClosestT(const TriangleDataT<T>& tri, const RayT<T>& ray) {
+	T t = planeClosestT(tri.a, tri.n, ray);
+	if (t == FLT_MAX || glm::abs(tri.denom) < EPSILON) {
+		return FLT_MAX;
+	}
+	glm::tvec3<T> v2 = (ray.origin + t * ray.dir) - tri.a;
+	T d20 = glm::dot(v2, tri.v0);
+	T d21 = glm::dot(v2, tri.v1);
+	T v = (tri.d11 * d20 - tri.d01 * d21) / tri.denom;
+	T w = (tri.d00 * d21 - tri.d01 * d20) / tri.denom;
+	T u = T(1) - v - w;
+	bool inside = u >= 0 && v >= 0 && w >= 0 && u <= 1 && v <= 1 && w <= 1;
+	return inside ? t : FLT_MAX;
+}
+
+/**
+ * @fn	template <class T> inline T geometricSphereClosestT(const glm::tvec3<T>& center, T radius, const RayT<T>& ray)
+ * @brief	Ray/sphere test, done geometrically.
+ * @param	center	The sphere's center.
+ * @param	radius	The sphere's radius.
+ * @param	ray   	The ray.
+ * @return	t of the hit, or FLT_MAX.
+ */
+
+template <class T>
+inline T geometricSphereClosestT(const glm::tvec3<T>& center, T radius, const RayT<T>& ray) {
+	glm::tvec3<T> oc = ray.origin - center;
+	T a = glm::dot(ray.dir, ray.dir);
+	T b = T(2) * glm::dot(oc, ray.dir);
+	T c = glm::dot(oc, oc) - radius * radius;
+	T discriminant = b * b - 4 * a * c;
+	if (discriminant < 0) {
+		return FLT_MAX;
+	}
+	T sqrtDiscriminant = std::sqrt(discriminant);
+	T t1 = (-b - sqrtDiscriminant) / (2 * a);
+	T t2 = (-b + sqrtDiscriminant) / (2 * a);
+	return (t1 > EPSILON) ? t1 : ((t2 > EPSILON) ? t2 : FLT_MAX);
+}
+
+/**
+ * @fn	inline void planeIntersectPacket(const dvec3& a, const dvec3& n, const RayPacket& packet, double tHit[])
+ * @brief	Vectorized version of planeClosestT.
+ * @param 		  	a	  	A point on the plane.
+ * @param 		  	n	  	The plane's unit normal.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the hit, FLT_MAX if none.
+ */
+
+inline void planeIntersectPacket(const dvec3& a, const dvec3& n, const RayPacket& packet, double tHit[]) {
+	PacketVec3 N(n);
+	PacketDouble denom = dot(packet.dir(), N);
+	PacketDouble t = dot(PacketVec3(a) - packet.origin(), N) / denom;
+	PacketMask hit = (abs(denom) >= PacketDouble(EPSILON)) & (t >= PacketDouble(EPSILON));
+	select(hit, t, PacketDouble(FLT_MAX)).store(tHit);
+}
+
+/**
+ * @fn	inline void diskIntersectPacket(const dvec3& center, const dvec3& n, double radius, const RayPacket& packet, double tHit[])
+ * @brief	Vectorized version of diskClosestT.
+ * @param 		  	center	The disk's center.
+ * @param 		  	n	  	The disk's unit normal.
+ * @param 		  	radius	The disk's radius.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the hit, FLT_MAX if none.
+ */
+
+inline void diskIntersectPacket(const dvec3& center, const dvec3& n, double radius,
+								const RayPacket& packet, double tHit[]) {
+	PacketVec3 o = packet.origin();
+	PacketVec3 d = packet.dir();
+	PacketVec3 N(n);
+	PacketDouble denom = dot(d, N);
+	PacketDouble t = dot(PacketVec3(center) - o, N) / denom;
+	PacketVec3 delta = (o + t * d) - PacketVec3(center);
+	PacketDouble dist = sqrt(dot(delta, delta));
+	PacketMask hit = (abs(denom) > PacketDouble(EPSILON)) & (t > PacketDouble(EPSILON)) &
+					 (dist <= PacketDouble(radius));
+	select(hit, t, PacketDouble(FLT_MAX)).store(tHit);
+}
+
+/**
+ * @fn	template <int FORM, class Q> inline void quadricIntersectPacket(const Q& q, const dvec3& center, const RayPacket& packet, double tHit[])
+ * @brief	Vectorized version of quadricClosestT: computes Aq, Bq and Cq for every
+ * 			ray at once and keeps the nearest root in front of each ray.
+ * @param 		  	q	  	The quadric's parameters, which must fit FORM.
+ * @param 		  	center	The quadric's center.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the hit, FLT_MAX if none.
+ */
+
+template <int FORM, class Q>
+inline void quadricIntersectPacket(const Q& q, const dvec3& center,
+									const RayPacket& packet, double tHit[]) {
+	PacketVec3 Ro = packet.origin() - PacketVec3(center);
+	PacketVec3 Rd = packet.dir();
+	PacketDouble A(q.A), B(q.B), C(q.C), J(q.J);
+	PacketDouble Aq, halfBq, Cq;
+	if (FORM == SPHERICAL_QUADRIC) {
+		Aq = A * dot(Rd, Rd);
+		halfBq = A * dot(Ro, Rd);
+		Cq = A * dot(Ro, Ro) + J;
+	} else {
+		Aq = A * (Rd.x * Rd.x) +
+			B * (Rd.y * Rd.y) +
+			C * (Rd.z * Rd.z);
+		halfBq = A * Ro.x * Rd.x +
+			B * Ro.y * Rd.y +
+			C * Ro.z * Rd.z;
+		Cq = A * (Ro.x * Ro.x) +
+			B * (Ro.y * Ro.y) +
+			C * (Ro.z * Ro.z) + J;
+		if (FORM == GENERAL_QUADRIC) {
+			PacketDouble D(q.D), E(q.E), F(q.F), G(q.G), H(q.H), I(q.I);
+			PacketDouble HALF(0.5);
+			Aq = Aq + D * (Rd.x * Rd.y) +
+				E * (Rd.x * Rd.z) +
+				F * (Rd.y * Rd.z);
+			halfBq = halfBq + HALF * (D * (Ro.x * Rd.y + Ro.y * Rd.x) +
+				E * (Ro.x * Rd.z + Ro.z * Rd.x) +
+				F * (Ro.y * Rd.z + Ro.z * Rd.y) +
+				G * Rd.x + H * Rd.y + I * Rd.z);
+			Cq = Cq + D * (Ro.x * Ro.y) +
+				E * (Ro.x * Ro.z) +
+				F * (Ro.y * Ro.z) +
+				G * Ro.x +
+				H * Ro.y +
+				I * Ro.z;
+		}
+	}
+
+	PacketDouble nearRoot, farRoot;
+	PacketMask hasRoots = quadratic(Aq, PacketDouble(2.0) * halfBq, Cq, nearRoot, farRoot);
+	PacketDouble eps(EPSILON);
+	PacketDouble t = select(nearRoot > eps, nearRoot,
+							select(farRoot > eps, farRoot, PacketDouble(FLT_MAX)));
+	select(hasRoots, t, PacketDouble(FLT_MAX)).store(tHit);
+}
+
+/**
+ * @fn	inline void triangleIntersectPacket(const TriangleData& tri, const RayPacket& packet, double tHit[])
+ * @brief	Vectorized version of triangleClosestT.
+ * @param 		  	tri   	The triangle.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the hit, FLT_MAX if none.
+ */
+
+inline void triangleIntersectPacket(const TriangleData& tri, const RayPacket& packet, double tHit[]) {
+	if (glm::abs(tri.denom) < EPSILON) {
+		PacketDouble(FLT_MAX).store(tHit);
+		return;
+	}
+	PacketVec3 o = packet.origin();
+	PacketVec3 d = packet.dir();
+	PacketVec3 N(tri.n);
+	PacketDouble planeDenom = dot(d, N);
+	PacketDouble t = dot(PacketVec3(tri.a) - o, N) / planeDenom;
+	PacketVec3 v2 = (o + t * d) - PacketVec3(tri.a);
+	PacketDouble d20 = dot(v2, PacketVec3(tri.v0));
+	PacketDouble d21 = dot(v2, PacketVec3(tri.v1));
+	PacketDouble denom(tri.denom);
+	PacketDouble v = (PacketDouble(tri.d11) * d20 - PacketDouble(tri.d01) * d21) / denom;
+	PacketDouble w = (PacketDouble(tri.d00) * d21 - PacketDouble(tri.d01) * d20) / denom;
+	PacketDouble u = PacketDouble(1.0) - v - w;
+	PacketDouble zero(0.0), one(1.0);
+	PacketMask hit = (abs(planeDenom) >= PacketDouble(EPSILON)) & (t >= PacketDouble(EPSILON)) &
+					 (u >= zero) & (v >= zero) & (w >= zero) &
+					 (u <= one) & (v <= one) & (w <= one);
+	select(hit, t, PacketDouble(FLT_MAX)).store(tHit);
+}
+
+/**
+ * @fn	inline void geometricSphereIntersectPacket(const dvec3& center, double radius, const RayPacket& packet, double tHit[])
+ * @brief	Vectorized version of geometricSphereClosestT.
+ * @param 		  	center	The sphere's center.
+ * @param 		  	radius	The sphere's radius.
+ * @param 		  	packet	The rays.
+ * @param [out]		tHit  	Per-lane t of the hit, FLT_MAX if none.
+ */
+
+inline void geometricSphereIntersectPacket(const dvec3& center, double radius,
+											const RayPacket& packet, double tHit[]) {
+	PacketVec3 oc = packet.origin() - PacketVec3(center);
+	PacketVec3 d = packet.dir();
+	PacketDouble a = dot(d, d);
+	PacketDouble b = PacketDouble(2.0) * dot(oc, d);
+	PacketDouble c = dot(oc, oc) - PacketDouble(radius * radius);
+	PacketDouble discriminant = b * b - PacketDouble(4.0) * a * c;
+	PacketDouble root = sqrt(max(discriminant, PacketDouble(0.0)));
+	PacketDouble t1 = (-b - root) / (PacketDouble(2.0) * a);
+	PacketDouble t2 = (-b + root) / (PacketDouble(2.0) * a);
+	PacketDouble eps(EPSILON);
+	PacketDouble t = select(t1 > eps, t1, select(t2 > eps, t2, PacketDouble(FLT_MAX)));
+	select(discriminant >= PacketDouble(0.0), t, PacketDouble(FLT_MAX)).store(tHit);
+}
@@ -0,0 +1,196 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <chrono>
+#include "threadpool.h"
+
+/**
+ * @fn	ThreadPool::ThreadPool(int numThreads)
+ * @brief	Constructs a thread pool. The thread calling parallelFor always
+ * 			helps out, so numThreads - 1 worker threads are started.
+ * @param	numThreads	Total number of threads to run tasks on. Values less than
+ * 						1 select one thread per hardware core.
+ */
+
+ThreadPool::ThreadPool(int numThreads)
+	: pendingTasks(0), shuttingDown(false) {
+	if (numThreads < 1) {
+		numThreads = defaultNumThreads();
+	}
+	for (int i = 0; i < numThreads - 1; i++) {
+		queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+	}
+	for (int i = 0; i < numThreads - 1; i++) {
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+	}
+}
+
+/**
+ * @fn	ThreadPool::~ThreadPool()
+ * @brief	Stops and joins all the worker threads.
+ */
+
+ThreadPool::~ThreadPool() {
+	shuttingDown = true;
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		workAvailable.notify_all();
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+/**
+ * @fn	int ThreadPool::defaultNumThreads()
+ * @brief	The number of hardware threads on this machine (at least 1).
+ * @return	The number of hardware threads.
+ */
+
+int ThreadPool::defaultNumThreads() {
+	int N = (int)std::thread::hardware_concurrency();
+	return N > 0 ? N : 1;
+}
+
+/**
+ * @fn	void ThreadPool::parallelFor(int numTasks, const std::function<void(int)>& task)
+ * @brief	Runs task(0), task(1), ... task(numTasks - 1) on the pool and waits until all
+ * 			of them are finished. The tasks are dealt out to the workers in contiguous
+ * 			blocks; workers that finish early steal from the others. Can be called
+ * 			from several threads at once, and from inside a task.
+ * @param	numTasks	Number of tasks.
+ * @param	task		The work to perform for each task index.
+ */
+
+void ThreadPool::parallelFor(int numTasks, const std::function<void(int)>& task) {
+	if (numTasks <= 0) {
+		return;
+	}
+	if (workers.empty() || numTasks == 1) {
+		for (int i = 0; i < numTasks; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	Job job;
+	job.body = &task;
+	job.remaining = numTasks;
+
+	const int N = (int)queues.size();
+	for (int q = 0; q < N; q++) {
+		int first = (int)((long long)numTasks * q / N);
+		int last = (int)((long long)numTasks * (q + 1) / N);
+		std::lock_guard<std::mutex> guard(queues[q]->lock);
+		for (int i = last - 1; i >= first; i--) {
+			queues[q]->tasks.push_back(Task{ &job, i });
+		}
+	}
+	pendingTasks += numTasks;
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		workAvailable.notify_all();
+	}
+
+	// Help out until every task of this job has been completed.
+	while (job.remaining > 0) {
+		Task t;
+		if (stealTask(-1, t)) {
+			runTask(t);
+		} else {
+			std::unique_lock<std::mutex> lock(sleepLock);
+			jobFinished.wait_for(lock, std::chrono::milliseconds(1),
+				[&job] { return job.remaining == 0; });
+		}
+	}
+}
+
+/**
+ * @fn	bool ThreadPool::popTask(int queueIndex, Task& task)
+ * @brief	Takes the most recently queued task from a worker's own deque.
+ * @param	queueIndex	Index of the worker's deque.
+ * @param [out]	task	The task, if one was found.
+ * @return	True iff a task was found.
+ */
+
+bool ThreadPool::popTask(int queueIndex, Task& task) {
+	WorkQueue& Q = *queues[queueIndex];
+	std::lock_guard<std::mutex> guard(Q.lock);
+	if (Q.tasks.empty()) {
+		return false;
+	}
+	task = Q.tasks.back();
+	Q.tasks.pop_back();
+	pendingTasks--;
+	return true;
+}
+
+/**
+ * @fn	bool ThreadPool::stealTask(int thiefIndex, Task& task)
+ * @brief	Takes the oldest task from some other worker's deque.
+ * @param	thiefIndex	Index of the stealing worker, or -1 if the thief is not a worker.
+ * @param [out]	task	The task, if one was found.
+ * @return	True iff a task was found.
+ */
+
+bool ThreadPool::stealTask(int thiefIndex, Task& task) {
+	const int N = (int)queues.size();
+	for (int i = 1; i <= N; i++) {
+		int victim = (thiefIndex + i + N) % N;
+		if (victim == thiefIndex) {
+			continue;
+		}
+		WorkQueue& Q = *queues[victim];
+		std::lock_guard<std::mutex> guard(Q.lock);
+		if (!Q.tasks.empty()) {
+			task = Q.tasks.front();
+			Q.tasks.pop_front();
+			pendingTasks--;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @fn	void ThreadPool::runTask(const Task& task)
+ * @brief	Runs a task, and wakes up waiters if it was the last one of its job.
+ * 			The job must not be touched after its counter is decremented,
+ * 			since the thread waiting on it is then free to return.
+ * @param	task	The task to run.
+ */
+
+void ThreadPool::runTask(const Task& task) {
+	(*task.job->body)(task.index);
+	if (--task.job->remaining == 0) {
+		std::lock_guard<std::mutex> guard(sleepLock);
+		jobFinished.notify_all();
+	}
+}
+
+/**
+ * @fn	void ThreadPool::workerLoop(int index)
+ * @brief	The body of each worker thread.
+ * @param	index	The worker's index, which is also the index of its deque.
+ */
+
+void ThreadPool::workerLoop(int index) {
+	while (true) {
+		Task t;
+		if (popTask(index, t) || stealTask(index, t)) {
+			runTask(t);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepLock);
+		workAvailable.wait(lock, [this] { return pendingTasks > 0 || shuttingDown; });
+		if (shuttingDown && pendingTasks == 0) {
+			return;
+		}
+	}
+}
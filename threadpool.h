@@ -0,0 +1,82 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+/**
+ * @class	ThreadPool
+ * @brief	A persistent pool of worker threads. Each worker owns a deque of tasks.
+ * 			A worker takes new work from the back of its own deque; when that runs
+ * 			dry, it steals from the front of the other workers' deques. The pool
+ * 			is meant to be created once and reused for every frame.
+ */
+
+class ThreadPool {
+public:
+	ThreadPool(int numThreads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int getNumThreads() const { return (int)workers.size() + 1; }
+	void parallelFor(int numTasks, const std::function<void(int)>& task);
+
+	static int defaultNumThreads();
+protected:
+	/**
+	 * @struct	Job
+	 * @brief	One call to parallelFor. Tracks how many of its tasks are unfinished.
+	 */
+
+	struct Job {
+		const std::function<void(int)>* body;	//!< the work to do for each task index
+		std::atomic<int> remaining;				//!< tasks not yet completed
+	};
+
+	/**
+	 * @struct	Task
+	 * @brief	A single unit of work: one index of one job.
+	 */
+
+	struct Task {
+		Job* job;
+		int index;
+	};
+
+	/**
+	 * @struct	WorkQueue
+	 * @brief	A worker's deque of tasks.
+	 */
+
+	struct WorkQueue {
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	bool popTask(int queueIndex, Task& task);
+	bool stealTask(int thiefIndex, Task& task);
+	void runTask(const Task& task);
+	void workerLoop(int index);
+
+	std::vector<std::thread> workers;					//!< the worker threads
+	std::vector<std::unique_ptr<WorkQueue>> queues;		//!< one deque per worker
+	std::atomic<int> pendingTasks;						//!< tasks sitting in the deques
+	std::atomic<bool> shuttingDown;						//!< true once the destructor starts
+	std::mutex sleepLock;								//!< guards the two condition variables
+	std::condition_variable workAvailable;				//!< signaled when tasks are queued
+	std::condition_variable jobFinished;				//!< signaled when any job completes
+};
@@ -0,0 +1,258 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#include <fstream>
+#include <sstream>
+#include "trianglemesh.h"
+
+/**
+ * @fn	ITriangleMesh::ITriangleMesh(const vector<dvec3>& vertices, const vector<glm::ivec3>& triangles)
+ * @brief	Constructs a mesh from shared vertices and per-triangle vertex indices.
+ * @param	vertices 	The vertices.
+ * @param	triangles	Vertex indices (0 based) of each triangle.
+ */
+
+ITriangleMesh::ITriangleMesh(const vector<dvec3>& vertices, const vector<glm::ivec3>& triangles)
+	: vertices(vertices), triangles(triangles) {
+	build();
+}
+
+/**
+ * @fn	ITriangleMesh::ITriangleMesh(const string& objFilename, const dmat4& transform)
+ * @brief	Loads a mesh from a Wavefront OBJ file. An error is reported and the mesh
+ * 			is left empty if the file cannot be read.
+ * @param	objFilename	Name of the OBJ file.
+ * @param	transform  	Applied to every vertex, e.g. to place the model in the scene.
+ */
+
+ITriangleMesh::ITriangleMesh(const string& objFilename, const dmat4& transform) {
+	loadOBJ(objFilename, vertices, triangles);
+	for (auto& v : vertices) {
+		v = dvec3(transform * dvec4(v, 1.0));
+	}
+	build();
+}
+
+/**
+ * @fn	bool ITriangleMesh::loadOBJ(const string& filename, vector<dvec3>& vertices, vector<glm::ivec3>& triangles)
+ * @brief	Reads the vertices and faces of a Wavefront OBJ file. Faces may use any of
+ * 			the v, v/vt, v//vn and v/vt/vn forms and negative (relative) indices;
+ * 			polygons are split into triangle fans. Everything else is ignored.
+ * @param 		  	filename 	Name of the file.
+ * @param [out]		vertices 	The vertices.
+ * @param [out]		triangles	Vertex indices (0 based) of each triangle.
+ * @return	True iff the file could be read. On a malformed vertex, false, with
+ * 			no vertices or triangles.
+ */
+
+bool ITriangleMesh::loadOBJ(const string& filename, vector<dvec3>& vertices, vector<glm::ivec3>& triangles) {
+	vertices.clear();
+	triangles.clear();
+	std::ifstream in(filename);
+	if (!in.is_open()) {
+		cout << "Error: Cannot open file " << filename << endl;
+		return false;
+	}
+
+	string line;
+	vector<int> face;
+	while (std::getline(in, line)) {
+		std::istringstream s(line);
+		string keyword;
+		s >> keyword;
+		if (keyword == "v") {
+			double x, y, z;
+			if (!(s >> x >> y >> z)) {
+				// Faces refer to vertices by position, so skipping one would
+				// shift every later index; give up on the file instead.
+				cout << "Error: Bad vertex in " << filename << ": " << line << endl;
+				vertices.clear();
+				triangles.clear();
+				return false;
+			}
+			vertices.push_back(dvec3(x, y, z));
+		} else if (keyword == "f") {
+			face.clear();
+			string corner;
+			while (s >> corner) {
+				// Only the vertex index (before any '/') matters here.
+				int index = atoi(corner.c_str());
+				if (index < 0) {
+					index += (int)vertices.size() + 1;
+				}
+				if (index < 1 || index > (int)vertices.size()) {
+					cout << "Error: Bad vertex index in " << filename << ": " << line << endl;
+					face.clear();
+					break;
+				}
+				face.push_back(index - 1);
+			}
+			for (size_t i = 2; i < face.size(); i++) {
+				triangles.push_back(glm::ivec3(face[0], face[i - 1], face[i]));
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @fn	void ITriangleMesh::build()
+ * @brief	Builds the hierarchy and the per-triangle intersection data. Triangles
+ * 			with zero area are dropped.
+ */
+
+void ITriangleMesh::build() {
+	vector<AABB> boxes;
+	vector<int> kept;
+	for (size_t i = 0; i < triangles.size(); i++) {
+		const glm::ivec3& tri = triangles[i];
+		const dvec3& a = vertices[tri.x];
+		const dvec3& b = vertices[tri.y];
+		const dvec3& c = vertices[tri.z];
+		if (glm::length(glm::cross(b - a, c - a)) == 0.0) {
+			continue;
+		}
+		AABB box;
+		box.expand(a);
+		box.expand(b);
+		box.expand(c);
+		box.lo -= dvec3(EPSILON);
+		box.hi += dvec3(EPSILON);
+		boxes.push_back(box);
+		kept.push_back((int)i);
+	}
+
+	vector<int> order;
+	BVH::buildHierarchy(boxes, nodes, order);
+
+	v0.clear();
+	edge1.clear();
+	edge2.clear();
+	normals.clear();
+	for (int prim : order) {
+		const glm::ivec3& tri = triangles[kept[prim]];
+		const dvec3& a = vertices[tri.x];
+		const dvec3& b = vertices[tri.y];
+		const dvec3& c = vertices[tri.z];
+		v0.push_back(a);
+		edge1.push_back(b - a);
+		edge2.push_back(c - a);
+		normals.push_back(glm::normalize(glm::cross(b - a, c - a)));
+	}
+}
+
+/**
+ * @fn	double ITriangleMesh::intersectTriangle(int i, const Ray& ray) const
+ * @brief	Moller-Trumbore ray/triangle test.
+ * @param	i  	Index of the triangle, in leaf order.
+ * @param	ray	The ray.
+ * @return	The t value of the intersection, or FLT_MAX if there is none.
+ */
+
+double ITriangleMesh::intersectTriangle(int i, const Ray& ray) const {
+	dvec3 p = glm::cross(ray.dir, edge2[i]);
+	double det = glm::dot(edge1[i], p);
+	if (glm::abs(det) < 1.0e-12) {
+		return FLT_MAX;
+	}
+	double invDet = 1.0 / det;
+	dvec3 s = ray.origin - v0[i];
+	double u = glm::dot(s, p) * invDet;
+	if (u < 0.0 || u > 1.0) {
+		return FLT_MAX;
+	}
+	dvec3 q = glm::cross(s, edge1[i]);
+	double v = glm::dot(ray.dir, q) * invDet;
+	if (v < 0.0 || u + v > 1.0) {
+		return FLT_MAX;
+	}
+	double t = glm::dot(edge2[i], q) * invDet;
+	return t > EPSILON ? t : FLT_MAX;
+}
+
+/**
+ * @fn	double ITriangleMesh::closestT(const Ray& ray, int& part) const
+ * @brief	Finds the closest triangle hit by a ray.
+ * @param 		  	ray 	The ray.
+ * @param [out]		part	Which triangle was hit.
+ * @return	The t value of the intersection, or FLT_MAX if there is none.
+ */
+
+double ITriangleMesh::closestT(const Ray& ray, int& part) const {
+	double tClosest = FLT_MAX;
+	part = 0;
+	double tMax = FLT_MAX;
+	BVH::traverse(nodes, ray.origin, inverseDirection(ray.dir), tMax,
+		[&](int start, int count, double& tCull) {
+			for (int i = start; i < start + count; i++) {
+				double t = intersectTriangle(i, ray);
+				if (t < tClosest) {
+					tClosest = t;
+					part = i;
+				}
+			}
+			tCull = tClosest;
+			return false;
+		});
+	return tClosest;
+}
+
+/**
+ * @fn	void ITriangleMesh::computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const
+ * @brief	Fills in the intercept point and the (flat) normal of the triangle hit.
+ * @param 		  	ray 	The ray.
+ * @param 		  	t   	Where the ray hit.
+ * @param 		  	part	The triangle, as reported by closestT.
+ * @param [in,out]	hit 	The hit.
+ */
+
+void ITriangleMesh::computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const {
+	hit.interceptPt = ray.getPoint(t);
+	hit.normal = normals[part];
+}
+
+/**
+ * @fn	bool ITriangleMesh::getBounds(AABB& box) const
+ * @brief	Bounding box of the whole mesh.
+ * @param [out]	box	The box.
+ * @return	True, unless the mesh has no triangles (e.g., it failed to load).
+ */
+
+bool ITriangleMesh::getBounds(AABB& box) const {
+	if (nodes.empty()) {
+		return false;
+	}
+	box = nodes[0].bounds;
+	return true;
+}
+
+/**
+ * @fn	bool ITriangleMesh::occluded(const Ray& ray, double tMax) const
+ * @brief	Determines whether any triangle is hit closer than tMax, stopping at the
+ * 			first one found.
+ * @param	ray 	The ray.
+ * @param	tMax	Distance of interest.
+ * @return	True iff the ray is blocked.
+ */
+
+bool ITriangleMesh::occluded(const Ray& ray, double tMax) const {
+	bool blocked = false;
+	double tLimit = tMax;
+	BVH::traverse(nodes, ray.origin, inverseDirection(ray.dir), tLimit,
+		[&](int start, int count, double&) {
+			for (int i = start; i < start + count; i++) {
+				if (intersectTriangle(i, ray) < tMax) {
+					blocked = true;
+					return true;
+				}
+			}
+			return false;
+		});
+	return blocked;
+}
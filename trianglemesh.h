@@ -0,0 +1,45 @@
+/****************************************************
+ * 2016-2024 Eric Bachmann and Mike Zmuda
+ * All Rights Reserved.
+ * NOTICE:
+ * Dissemination of this information or reproduction
+ * of this material is prohibited unless prior written
+ * permission is granted.
+ ****************************************************/
+
+#pragma once
+#include <vector>
+#include <string>
+#include "defs.h"
+#include "ishape.h"
+#include "bvh.h"
+
+/**
+ * @struct	ITriangleMesh
+ * @brief	An indexed triangle mesh, ray traced as one shape. The triangles share
+ * 			one vertex array; each keeps the edge vectors Moller-Trumbore needs and
+ * 			its unit normal, and a BVH over the triangles keeps tests per ray
+ * 			logarithmic. The part reported by closestT identifies the triangle.
+ */
+
+struct ITriangleMesh : public IShape {
+	vector<dvec3> vertices;			//!< shared vertex storage
+	vector<glm::ivec3> triangles;	//!< vertex indices (0 based) of each triangle
+
+	ITriangleMesh(const vector<dvec3>& vertices, const vector<glm::ivec3>& triangles);
+	ITriangleMesh(const string& objFilename, const dmat4& transform = dmat4(1.0));
+	virtual double closestT(const Ray& ray, int& part) const override;
+	virtual void computeHitAttributes(const Ray& ray, double t, int part, HitRecord& hit) const override;
+	virtual bool getBounds(AABB& box) const override;
+	virtual bool occluded(const Ray& ray, double tMax) const override;
+	int getNumTriangles() const { return (int)triangles.size(); }
+	static bool loadOBJ(const string& filename, vector<dvec3>& vertices, vector<glm::ivec3>& triangles);
+protected:
+	vector<dvec3> v0;			//!< first vertex of each triangle, in BVH leaf order
+	vector<dvec3> edge1;		//!< v1 - v0, in BVH leaf order
+	vector<dvec3> edge2;		//!< v2 - v0, in BVH leaf order
+	vector<dvec3> normals;		//!< unit normal, in BVH leaf order
+	vector<BVHNode> nodes;		//!< hierarchy over the triangles
+	void build();
+	double intersectTriangle(int i, const Ray& ray) const;
+};
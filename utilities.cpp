@@ -358,17 +358,36 @@ double map(double x, double fromLo, double fromHi, double toLow, double toHigh)
  */
 
 vector<double> quadratic(double A, double B, double C) {
-	vector<double> result;
-	if (A == 0) return result;
-	double discriminant = B * B - 4 * A * C;
+	double roots[2];
+	int numRoots = quadratic(A, B, C, roots);
+	return vector<double>(roots, roots + numRoots);
+}
 
-	if (discriminant >= 0) result.push_back((-B - sqrt(discriminant)) / (2 * A));
+/**
+ * @fn	template <class T> static int solveQuadratic(T A, T B, T C, T roots[2])
+ * @brief	The quadratic() solver, in either precision.
+ */
+
+template <class T>
+static int solveQuadratic(T A, T B, T C, T roots[2]) {
+	if (A == 0) return 0;
+	T discriminant = B * B - 4 * A * C;
 
 	if (discriminant > 0) {
-		result.push_back((-B + sqrt(discriminant)) / (2 * A));
-		if (result[0] > result[1]) swap(result[0], result[1]);
+		// q gets the sign of -B, so -B and the square root never cancel each
+		// other out; the second root then follows from r0 * r1 = C / A.
+		T root = std::sqrt(discriminant);
+		T q = T(-0.5) * (B < 0 ? B - root : B + root);
+		roots[0] = q / A;
+		roots[1] = C / q;
+		if (roots[0] > roots[1]) std::swap(roots[0], roots[1]);
+		return 2;
 	}
-	return result;
+	if (discriminant == 0) {
+		roots[0] = -B / (2 * A);
+		return 1;
+	}
+	return 0;
 }
 
 /**
@@ -400,19 +419,27 @@ vector<double> quadratic(double A, double B, double C) {
  * @test	quadratic(1, 4, 3, ary) --> returns 2 and fills in ary with: [-3,-1]
  * @test	quadratic(1 ,0, 0, ary) --> returns 1 and fills in ary with: [0]
  * @test	quadratic(-4, -2, -1, ary) --> returns 0 and does not modify ary.
+ * @test	quadratic(1, 1.0e8, 1, ary) --> returns 2 and fills in ary with: [-1.0e8,-1.0e-8]
+ * 			(the small root is accurate; the textbook formula loses it to cancellation)
  * @return	The number of real roots put into the array 'roots'
 */
 
 int quadratic(double A, double B, double C, double roots[2]) {
-	if (A == 0) return 0;
-
-	vector<double> result = quadratic(A, B, C);
-	int rootCount = (int) result.size();
+	return solveQuadratic(A, B, C, roots);
+}
 
-	if (rootCount > 0) roots[0] = result[0];
-	if (rootCount > 1) roots[1] = result[1];
+/**
+ * @fn	int quadratic(float A, float B, float C, float roots[2])
+ * @brief	Single precision version of quadratic(), for the float tracer.
+ * @param	A	 	A.
+ * @param	B	 	B.
+ * @param	C	 	C.
+ * @param	roots	The real roots, in ascending order.
+ * @return	The number of real roots put into the array 'roots'
+ */
 
-	return rootCount;
+int quadratic(float A, float B, float C, float roots[2]) {
+	return solveQuadratic(A, B, C, roots);
 }
 
 /**
@@ -923,7 +950,7 @@ string extractBaseFilename(const string& str) {
 	return str.substr(pos + 1);
 }
 
-bool DEBUG_PIXEL = false;
+thread_local bool DEBUG_PIXEL = false;
 int xDebug = -1, yDebug = -1;
 
 void mouseUtility(int b, int s, int x, int y) {
@@ -950,10 +977,10 @@ void keyboardUtility(unsigned char key, int x, int y) {
 }
 
 void graphicsInit(int argc, char* argv[], const std::string& windowName, int width, int height) {
+#ifndef CONSOLE_ONLY
 #ifndef WINDOWS
-	setenv("DISPLAY", ":0.0", 1);
+	setenv("DISPLAY", ":0.0", 0);		// keep any display the user already chose
 #endif
-#ifndef CONSOLE_ONLY
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_RGB | GLUT_SINGLE);
 	glutInitWindowSize(width, height);
@@ -15,7 +15,7 @@
 #include <string>
 #include "defs.h"
 
-extern bool DEBUG_PIXEL;
+extern thread_local bool DEBUG_PIXEL;
 extern int xDebug, yDebug;
 void mouseUtility(int, int, int, int);
 void keyboardUtility(unsigned char key, int x, int y);
@@ -51,6 +51,7 @@ double map(double x, double xLow, double xHigh, double yLow, double yHigh);
 
 vector<double> quadratic(double A, double B, double C);
 int quadratic(double A, double B, double C, double roots[2]);
+int quadratic(float A, float B, float C, float roots[2]);
 
 double areaOfParallelogram(const dvec3& v1, const dvec3& v2);
 double areaOfTriangle(const dvec3& pt1, const dvec3& pt2, const dvec3& pt3);
@@ -11,6 +11,8 @@
 #include "vertexops.h"
 
 Render_Mode VertexOps::polygonRenderMode = FILL;
+int VertexOps::numThreads = 1;
+std::unique_ptr<ThreadPool> VertexOps::pool;
 
  // Planes describing the normalized device coordinates view volume - 2x2x2 cube
 
@@ -239,6 +241,27 @@ vector<VertexData> VertexOps::transformVertices(const dmat4& TM, const vector<Ve
 	return transformedVertices;
 }
 
+/**
+ * @fn	ThreadPool* VertexOps::rasterizerPool()
+ * @brief	The threads filled triangles are rasterized on, (re)created when
+ * 			numThreads changes. Like the rest of VertexOps' state, it is shared
+ * 			by all callers, so render is not to be called from several threads
+ * 			at once.
+ * @return	The pool; nullptr if numThreads asks for one thread.
+ */
+
+ThreadPool* VertexOps::rasterizerPool() {
+	int threadsWanted = numThreads > 0 ? numThreads : ThreadPool::defaultNumThreads();
+	if (threadsWanted == 1) {
+		pool.reset();
+		return nullptr;
+	}
+	if (pool == nullptr || pool->getNumThreads() != threadsWanted) {
+		pool.reset(new ThreadPool(threadsWanted));
+	}
+	return pool.get();
+}
+
 double computeNearPlane(const dmat4& PM) {
 	double alpha = PM[2][2];
 	double beta = PM[3][2];
@@ -304,7 +327,7 @@ void VertexOps::processTriangleVertices(FrameBuffer& frameBuffer, const dvec3& e
 
 	// Determine the rendering mode for the trangle
 	if (VertexOps::polygonRenderMode == FILL) {
-		drawManyFilledTriangles(frameBuffer, eyePos, lights, windowCoords, eyeFrame);
+		drawManyFilledTriangles(frameBuffer, eyePos, lights, windowCoords, eyeFrame, rasterizerPool());
 	}
 	else {
 		drawManyWireFrameTriangles(frameBuffer, eyePos, lights, windowCoords, eyeFrame);
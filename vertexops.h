@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <memory>
 #include "defs.h"
 #include "framebuffer.h"
 #include "light.h"
@@ -64,6 +65,7 @@ public:
 	static dmat4 getViewportTransformation(int left, int width, int bottom, int height);
 
 	static Render_Mode polygonRenderMode;
+	static int numThreads;		//!< threads filled triangles are rasterized on. 1 (the default) ==> serial; < 1 ==> one per core
 
 protected:
 	static vector<VertexData> clipAgainstPlane(vector<VertexData>& verts, const IPlane& plane);
@@ -76,4 +78,7 @@ protected:
 	static vector<VertexData> transformVerticesToWorldCoordinates(const dmat4& modelMatrix,
 		const vector<VertexData>& vertices);
 	static vector<VertexData> transformVertices(const dmat4& TM, const vector<VertexData>& vertices);
+	static ThreadPool* rasterizerPool();
+
+	static std::unique_ptr<ThreadPool> pool;	//!< sized from numThreads by rasterizerPool
 };